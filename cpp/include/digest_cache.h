@@ -0,0 +1,57 @@
+#ifndef EEE4120F_YODA_DIGEST_CACHE_H
+#define EEE4120F_YODA_DIGEST_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Identity and change metadata of a file. A cached digest is only used while all of it matches;
+// ctime cannot be set from user space, so a rewrite that restores the old mtime still misses.
+typedef struct {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtimeNs;
+    int64_t ctimeNs;
+} FileKey;
+
+bool fileKey(int fd, FileKey& key);
+
+// Digests of files kept in a memory-mapped open-addressing table, one slot per (device, inode).
+// Any number of processes may use the same cache file: lookups take no lock (every slot is a
+// seqlock), stores take an exclusive flock on the file. A full table is rewritten at twice the
+// size and renamed over the old file.
+class DigestCache {
+public:
+    DigestCache();
+    ~DigestCache();
+
+    // Create or map the cache file; algorithm ("md5", "md6-256") must match an existing file's
+    bool open(const std::string& path, const std::string& algorithm, size_t digestLength);
+    void close();
+
+    bool lookup(const FileKey& key, uint8_t* digest) const;
+    bool store(const FileKey& key, const uint8_t* digest);
+    uint64_t entries() const;
+
+private:
+    bool map(int file);
+    bool lockCurrent();
+    bool grow();
+
+    std::string path;
+    std::string algorithm;
+    size_t digestLen;
+    int fd;
+    uint8_t* base;
+    size_t mappedSize;
+};
+
+// Digest of the file at path: from the cache while its key matches, otherwise computed by hashFd and
+// stored. Files modified during the last 2 seconds are hashed but not stored, since a write within the
+// same timestamp tick as the read would not change their key.
+bool hashFileCached(const std::string& path, DigestCache* cache, const std::function<bool(int, uint8_t*)>& hashFd,
+                    uint8_t* digest, bool& hit);
+
+#endif //EEE4120F_YODA_DIGEST_CACHE_H
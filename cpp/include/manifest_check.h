@@ -0,0 +1,26 @@
+#ifndef EEE4120F_YODA_MANIFEST_CHECK_H
+#define EEE4120F_YODA_MANIFEST_CHECK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include "digest_cache.h"
+
+struct ManifestOptions {
+    unsigned int threads = 0;      // 0: one per core
+    bool quiet = false;            // Only print failures
+    bool failFast = false;         // Stop at the first failure in manifest order
+    DigestCache* cache = nullptr;  // Digests of unchanged files are taken from here
+};
+
+// Verify an md5sum-style manifest ("<hex digest>  <path>" per line, "-" for standard input).
+// Files are hashed by a pool of threads in order of their first physical extent, so the disk sees
+// one forward sweep, while the results are printed as "<path>: OK" or "<path>: FAILED" in manifest
+// order as soon as every earlier entry is done. Returns the number of failed entries.
+size_t checkManifest(const std::string& manifestPath, size_t digestLength,
+                     const std::function<bool(int, uint8_t*)>& hashFd, const std::string& toolName,
+                     const ManifestOptions& options, std::ostream& out);
+
+#endif //EEE4120F_YODA_MANIFEST_CHECK_H
@@ -0,0 +1,30 @@
+#ifndef EEE4120F_YODA_MD5_H
+#define EEE4120F_YODA_MD5_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Streaming MD5 state: the chaining values, the number of bytes absorbed and a partial block
+typedef struct {
+    uint32_t A, B, C, D;
+    uint64_t length;
+    uint8_t buffer[64];
+    size_t bufferLen;
+} MD5Context;
+
+// Calculate the MD5 hash of the input message
+std::array<uint8_t, 16> calculate(const std::string& inputStr);
+
+// Streaming interface for messages that do not fit in memory
+void md5Init(MD5Context& ctx);
+void md5Update(MD5Context& ctx, const uint8_t* data, size_t len);
+std::array<uint8_t, 16> md5Final(MD5Context& ctx);
+
+// Compact snapshot of a context (chaining values, length and only the buffered bytes) and its restore
+std::vector<uint8_t> md5Snapshot(const MD5Context& ctx);
+bool md5Restore(MD5Context& ctx, const std::vector<uint8_t>& snapshot);
+
+#endif //EEE4120F_YODA_MD5_H
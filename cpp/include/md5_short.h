@@ -0,0 +1,115 @@
+#ifndef EEE4120F_YODA_MD5_SHORT_H
+#define EEE4120F_YODA_MD5_SHORT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// MD5 for messages of at most 119 bytes, which pad to one block (up to 55 bytes) or two. The padded
+// blocks are built as words in registers rather than in a heap buffer, and the compression is fully
+// unrolled, so words known at compile time (the 0x80 byte, the zero words and the length) fold into
+// the round constants.
+
+// Round tables, shared with the general block loop in md5.cpp
+static constexpr uint32_t md5S[64] = {
+        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+        5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static constexpr uint32_t md5K[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static constexpr uint32_t md5G[64] = {
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        1, 6, 11, 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12,
+        5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2,
+        0, 7, 14, 5, 12, 3, 10, 1, 8, 15, 6, 13, 4, 11, 2, 9
+};
+
+static constexpr uint32_t md5IV[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+// One compression of a block given as words
+static inline __attribute__((always_inline)) void md5CompressWords(uint32_t state[4], const uint32_t M[16]) {
+    uint32_t AA = state[0], BB = state[1], CC = state[2], DD = state[3];
+
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; ++i) {
+        uint32_t f;
+        if (i < 16) f = (BB & CC) | (~BB & DD);
+        else if (i < 32) f = (BB & DD) | (CC & ~DD);
+        else if (i < 48) f = BB ^ CC ^ DD;
+        else f = CC ^ (BB | ~DD);
+
+        f = f + AA + md5K[i] + M[md5G[i]];
+        AA = DD;
+        DD = CC;
+        CC = BB;
+        BB = BB + ((f << md5S[i]) | (f >> (32 - md5S[i])));
+    }
+
+    state[0] += AA;
+    state[1] += BB;
+    state[2] += CC;
+    state[3] += DD;
+}
+
+static inline std::array<uint8_t, 16> md5StateBytes(const uint32_t state[4]) {
+    std::array<uint8_t, 16> result;
+    for (int i = 0; i < 16; ++i) {
+        result[i] = (uint8_t) (state[i / 4] >> ((i % 4) * 8));
+    }
+    return result;
+}
+
+// Word j of the padded N-byte message: message bytes, 0x80, zeros, then the 64-bit length in bits
+template<size_t N>
+static inline __attribute__((always_inline)) uint32_t md5PaddedWord(const uint8_t* data, size_t j) {
+    constexpr size_t lengthAt = ((N + 8) / 64 + 1) * 64 - 8;
+    uint32_t word = 0;
+
+#pragma GCC unroll 4
+    for (size_t b = 0; b < 4; ++b) {
+        size_t pos = j * 4 + b;
+        uint32_t byte = (pos < N) ? data[pos]
+                      : (pos == N) ? 0x80
+                      : (pos >= lengthAt) ? (uint32_t) (((uint64_t) N * 8) >> ((pos - lengthAt) * 8)) & 0xff
+                      : 0;
+        word |= byte << (b * 8);
+    }
+    return word;
+}
+
+// MD5 of a message whose length N is known at compile time
+template<size_t N>
+std::array<uint8_t, 16> md5Fixed(const uint8_t* data) {
+    static_assert(N <= 119, "md5Fixed covers messages that pad to one or two blocks");
+    uint32_t state[4] = {md5IV[0], md5IV[1], md5IV[2], md5IV[3]};
+    uint32_t M[16];
+
+#pragma GCC unroll 16
+    for (size_t j = 0; j < 16; ++j) M[j] = md5PaddedWord<N>(data, j);
+    md5CompressWords(state, M);
+
+    if constexpr (N > 55) {
+#pragma GCC unroll 16
+        for (size_t j = 0; j < 16; ++j) M[j] = md5PaddedWord<N>(data, 16 + j);
+        md5CompressWords(state, M);
+    }
+    return md5StateBytes(state);
+}
+
+// MD5 of a message whose length is known at run time, without allocating. Messages of at most 119
+// bytes take the one- and two-block path, longer ones go through the streaming context.
+std::array<uint8_t, 16> md5Short(const uint8_t* data, size_t length);
+
+#endif //EEE4120F_YODA_MD5_SHORT_H
@@ -0,0 +1,312 @@
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "digest_cache.h"
+
+static const char cacheMagic[8] = {'Y', 'O', 'D', 'A', 'D', 'C', '0', '1'};
+static const uint64_t initialCapacity = 1 << 12;
+
+struct CacheHeader {
+    char magic[8];
+    char algorithm[16];
+    uint32_t digestLength;
+    uint32_t reserved;
+    uint64_t capacity;             // Slots, a power of two
+    std::atomic<uint64_t> count;   // Slots in use
+    uint8_t pad[16];
+};
+
+// sequence is odd while a store rewrites the slot; a reader that sees it change retries or misses
+struct CacheEntry {
+    std::atomic<uint32_t> sequence;
+    uint32_t used;
+    FileKey key;
+    uint8_t digest[64];
+    uint8_t pad[16];
+};
+
+static_assert(sizeof(CacheHeader) == 64 && sizeof(CacheEntry) == 128, "cache layout");
+
+static uint64_t slotOf(const FileKey& key, uint64_t capacity) {
+    uint64_t h = key.device * 0x9e3779b97f4a7c15ULL ^ key.inode;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h & (capacity - 1);
+}
+
+static bool sameFile(const FileKey& a, const FileKey& b) {
+    return a.device == b.device && a.inode == b.inode;
+}
+
+static bool sameVersion(const FileKey& a, const FileKey& b) {
+    return sameFile(a, b) && a.size == b.size && a.mtimeNs == b.mtimeNs && a.ctimeNs == b.ctimeNs;
+}
+
+bool fileKey(int fd, FileKey& key) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    key.device = st.st_dev;
+    key.inode = st.st_ino;
+    key.size = st.st_size;
+#ifdef __APPLE__
+    key.mtimeNs = st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+    key.ctimeNs = st.st_ctimespec.tv_sec * 1000000000LL + st.st_ctimespec.tv_nsec;
+#else
+    key.mtimeNs = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    key.ctimeNs = st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec;
+#endif
+    return true;
+}
+
+DigestCache::DigestCache() : digestLen(0), fd(-1), base(nullptr), mappedSize(0) {
+}
+
+DigestCache::~DigestCache() {
+    close();
+}
+
+// Write an empty table of the given capacity to a new file
+static bool createTable(int file, const std::string& algorithm, size_t digestLength, uint64_t capacity) {
+    if (ftruncate(file, sizeof(CacheHeader) + capacity * sizeof(CacheEntry)) != 0) return false;
+
+    CacheHeader header;
+    memset((void*) &header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    strncpy(header.algorithm, algorithm.c_str(), sizeof(header.algorithm) - 1);
+    header.digestLength = digestLength;
+    header.capacity = capacity;
+    return pwrite(file, &header, sizeof(header), 0) == sizeof(header);
+}
+
+bool DigestCache::open(const std::string& cachePath, const std::string& alg, size_t digestLength) {
+    close();
+    if (digestLength > sizeof(CacheEntry::digest) || alg.size() >= sizeof(CacheHeader::algorithm)) return false;
+    path = cachePath;
+    algorithm = alg;
+    digestLen = digestLength;
+
+    int file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) return false;
+
+    // The first process to open the file writes the header, under the lock so no one reads it half done
+    flock(file, LOCK_EX);
+    struct stat st;
+    bool ok = fstat(file, &st) == 0 && (st.st_size > 0 || createTable(file, algorithm, digestLen, initialCapacity));
+    flock(file, LOCK_UN);
+
+    if (!ok || !map(file)) {
+        ::close(file);
+        close();
+        return false;
+    }
+
+    const auto* header = (const CacheHeader*) base;
+    if (memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 || algorithm != header->algorithm ||
+        header->digestLength != digestLen) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool DigestCache::map(int file) {
+    struct stat st;
+    if (fstat(file, &st) != 0 || (size_t) st.st_size < sizeof(CacheHeader)) return false;
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (mapped == MAP_FAILED) return false;
+
+    if (base != nullptr) munmap(base, mappedSize);
+    if (fd >= 0 && fd != file) ::close(fd);
+    fd = file;
+    base = (uint8_t*) mapped;
+    mappedSize = st.st_size;
+    return true;
+}
+
+void DigestCache::close() {
+    if (base != nullptr) munmap(base, mappedSize);
+    if (fd >= 0) ::close(fd);
+    base = nullptr;
+    mappedSize = 0;
+    fd = -1;
+}
+
+uint64_t DigestCache::entries() const {
+    return base ? ((const CacheHeader*) base)->count.load(std::memory_order_relaxed) : 0;
+}
+
+bool DigestCache::lookup(const FileKey& key, uint8_t* digest) const {
+    if (base == nullptr) return false;
+    const auto* header = (const CacheHeader*) base;
+    auto* entries = (CacheEntry*) (base + sizeof(CacheHeader));
+    uint64_t capacity = header->capacity;
+    if (sizeof(CacheHeader) + capacity * sizeof(CacheEntry) > mappedSize) return false;
+
+    for (uint64_t probe = 0, slot = slotOf(key, capacity); probe < capacity; probe++, slot = (slot + 1) & (capacity - 1)) {
+        CacheEntry& e = entries[slot];
+        uint32_t before = e.sequence.load(std::memory_order_acquire);
+        if (before & 1) return false;  // Being rewritten: hash the file instead of waiting
+
+        uint32_t used = e.used;
+        FileKey stored = e.key;
+        uint8_t copy[sizeof(e.digest)];
+        memcpy(copy, e.digest, digestLen);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.sequence.load(std::memory_order_relaxed) != before) return false;
+
+        if (!used) return false;
+        if (sameFile(stored, key)) {
+            if (!sameVersion(stored, key)) return false;
+            memcpy(digest, copy, digestLen);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lock the file that path names now, remapping first if another process has replaced it
+bool DigestCache::lockCurrent() {
+    while (true) {
+        if (flock(fd, LOCK_EX) != 0) return false;
+
+        struct stat mine, current;
+        if (fstat(fd, &mine) == 0 && stat(path.c_str(), &current) == 0 && mine.st_ino == current.st_ino &&
+            mine.st_dev == current.st_dev) {
+            return true;
+        }
+
+        flock(fd, LOCK_UN);
+        int file = ::open(path.c_str(), O_RDWR);
+        if (file < 0 || !map(file)) {
+            if (file >= 0) ::close(file);
+            return false;
+        }
+    }
+}
+
+static void writeEntry(CacheEntry& e, const FileKey& key, const uint8_t* digest, size_t digestLen) {
+    uint32_t sequence = e.sequence.load(std::memory_order_relaxed);
+    e.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.used = 1;
+    e.key = key;
+    memcpy(e.digest, digest, digestLen);
+    e.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Called with the lock held: copy every entry into a table twice the size and swap it in
+bool DigestCache::grow() {
+    const auto* header = (const CacheHeader*) base;
+    const auto* entries = (const CacheEntry*) (base + sizeof(CacheHeader));
+    uint64_t capacity = header->capacity * 2;
+
+    std::string temp = path + ".grow";
+    int file = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) return false;
+    if (!createTable(file, algorithm, digestLen, capacity)) {
+        ::close(file);
+        unlink(temp.c_str());
+        return false;
+    }
+
+    size_t size = sizeof(CacheHeader) + capacity * sizeof(CacheEntry);
+    auto* target = (uint8_t*) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (target == MAP_FAILED) {
+        ::close(file);
+        unlink(temp.c_str());
+        return false;
+    }
+
+    auto* targetHeader = (CacheHeader*) target;
+    auto* targetEntries = (CacheEntry*) (target + sizeof(CacheHeader));
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < header->capacity; i++) {
+        if (!entries[i].used) continue;
+        uint64_t slot = slotOf(entries[i].key, capacity);
+        while (targetEntries[slot].used) slot = (slot + 1) & (capacity - 1);
+        writeEntry(targetEntries[slot], entries[i].key, entries[i].digest, digestLen);
+        count++;
+    }
+    targetHeader->count = count;
+    munmap(target, size);
+
+    // Lock the new file before it becomes visible, so that waiting writers find it locked
+    flock(file, LOCK_EX);
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        ::close(file);
+        unlink(temp.c_str());
+        return false;
+    }
+    flock(fd, LOCK_UN);
+    return map(file);
+}
+
+bool DigestCache::store(const FileKey& key, const uint8_t* digest) {
+    if (base == nullptr || !lockCurrent()) return false;
+
+    bool stored = false;
+    while (true) {
+        auto* header = (CacheHeader*) base;
+        auto* entries = (CacheEntry*) (base + sizeof(CacheHeader));
+        uint64_t capacity = header->capacity;
+
+        uint64_t slot = slotOf(key, capacity);
+        while (entries[slot].used && !sameFile(entries[slot].key, key)) slot = (slot + 1) & (capacity - 1);
+
+        if (entries[slot].used) {
+            writeEntry(entries[slot], key, digest, digestLen);
+            stored = true;
+            break;
+        }
+
+        // Keep the load below 70% so probes stay short
+        if ((header->count + 1) * 10 > capacity * 7) {
+            if (!grow()) break;
+            continue;
+        }
+
+        writeEntry(entries[slot], key, digest, digestLen);
+        header->count.fetch_add(1, std::memory_order_relaxed);
+        stored = true;
+        break;
+    }
+
+    flock(fd, LOCK_UN);
+    return stored;
+}
+
+bool hashFileCached(const std::string& path, DigestCache* cache, const std::function<bool(int, uint8_t*)>& hashFd,
+                    uint8_t* digest, bool& hit) {
+    hit = false;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    FileKey before, after;
+    bool ok = fileKey(fd, before);
+    if (ok && cache != nullptr && cache->lookup(before, digest)) {
+        hit = true;
+        close(fd);
+        return true;
+    }
+
+    ok = ok && hashFd(fd, digest) && fileKey(fd, after);
+    close(fd);
+    if (!ok) return false;
+
+    // Only a digest of a file that sat still while it was read, and for a while before, is cached
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t nowNs = now.tv_sec * 1000000000LL + now.tv_nsec;
+    if (cache != nullptr && sameVersion(before, after) && nowNs - after.mtimeNs > 2000000000LL) {
+        cache->store(after, digest);
+    }
+    return true;
+}
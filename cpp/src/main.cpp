@@ -0,0 +1,401 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "digest_cache.h"
+#include "manifest_check.h"
+#include "md5.h"
+#include "md5_short.h"
+
+void runTests() {
+    int executions = 100;
+    std::vector<double> times(executions, 0); // Vector to store all execution times
+
+    // Loop over different input sizes
+    for (unsigned long long inputSize = 0; inputSize <= pow(2, 23); inputSize += 4 * ceil(pow(2, 23) / 400)) {
+        // Generate input string of the required size
+        std::string inputS(inputSize, 'a'); // Fill the string with 'a'
+
+        std::cout << "Running " << executions << " executions of MD5 hashing on input size " << inputSize << "\n";
+
+        for (int i = 0; i < executions; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            std::array<uint8_t, 16> hash = calculate(inputS);
+            (void) hash;
+
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+
+            times[i] = diff.count(); // Store execution time in vector
+        }
+
+        // Write the execution times to a CSV file
+        std::ofstream outputFile("execution_times.csv", std::ios_base::app); // Append to the file
+        if (inputSize == 0) {
+            outputFile << "Run Number,Message Size,Execution Time\n"; // Write the headers
+        }
+        for (int i = 0; i < executions; ++i) {
+            outputFile << i+1 << "," << inputSize << "," << times[i] << "\n";
+        }
+        outputFile.close();
+
+        // Clear the vector
+        times.clear();
+    }
+}
+
+void singleTest() {
+    std::string input = "The quick brown fox jumps over the lazy dog";
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::array<uint8_t, 16> hash = calculate(input);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    std::cout << "MD5 hash of '" << input << "': ";
+    for (uint8_t byte : hash) {
+        std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
+    }
+    std::cout << "\n";
+    // Expected hash: 9e107d9d372bb6826bd81d3542a419d6
+
+    std::cout << "Execution time: " << diff.count() << " s\n";
+}
+
+void runCheckpointTests() {
+    uint64_t streamSize = 1ULL << 30;      // 1 GiB stream
+    uint64_t pieceSize = 1 << 20;          // fed 1 MiB at a time
+    uint64_t checkpointEvery = 1ULL << 28; // checkpoint every 256 MiB
+    std::vector<uint8_t> piece(pieceSize);
+
+    MD5Context ctx, resumed;
+    std::vector<uint8_t> snapshot;
+    uint64_t snapshotOffset = 0;
+
+    std::cout << "Running MD5 checkpoint test on a " << streamSize << " byte stream\n";
+
+    md5Init(ctx);
+    for (uint64_t offset = 0; offset < streamSize; offset += pieceSize) {
+        if (offset > 0 && offset % checkpointEvery == 0) {
+            auto start = std::chrono::high_resolution_clock::now();
+            snapshot = md5Snapshot(ctx);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+
+            snapshotOffset = offset;
+            std::cout << "Snapshot at " << offset << " bytes: " << snapshot.size() << " bytes, taken in "
+                      << diff.count() * 1e6 << " us\n";
+        }
+
+        for (uint64_t i = 0; i < pieceSize; ++i) piece[i] = (uint8_t) ((offset + i) * 2654435761u >> 13);
+        md5Update(ctx, piece.data(), pieceSize);
+    }
+    std::array<uint8_t, 16> hash = md5Final(ctx);
+
+    // Resume from the last snapshot as a restarted job would
+    bool restored = md5Restore(resumed, snapshot);
+    for (uint64_t offset = snapshotOffset; offset < streamSize; offset += pieceSize) {
+        for (uint64_t i = 0; i < pieceSize; ++i) piece[i] = (uint8_t) ((offset + i) * 2654435761u >> 13);
+        md5Update(resumed, piece.data(), pieceSize);
+    }
+    std::array<uint8_t, 16> resumedHash = md5Final(resumed);
+
+    std::cout << "Resumed digest " << (restored && hash == resumedHash ? "matches" : "DOES NOT MATCH")
+              << " the uninterrupted digest\n";
+}
+
+// Write test vectors for the Verilog testbenches: one line per random single-block message (0 to 55 bytes)
+// holding the padded 512-bit block followed by the digest from calculate(), both in hex
+void writeTestVectors(const std::string& path, int count) {
+    std::ofstream outputFile(path);
+    std::mt19937 rng(4120);
+
+    for (int i = 0; i < count; ++i) {
+        std::string message(rng() % 56, '\0');
+        for (char& ch : message) {
+            ch = (char) (rng() & 0xff);
+        }
+
+        // Padded block as calculate() builds it: message, 0x80, zeros, 64-bit little-endian bit length
+        uint8_t block[64] = {0};
+        uint64_t bitLen = message.size() * 8;
+        std::copy(message.begin(), message.end(), block);
+        block[message.size()] = 0x80;
+        for (int j = 0; j < 8; ++j) {
+            block[56 + j] = bitLen >> (j * 8);
+        }
+
+        std::array<uint8_t, 16> hash = calculate(message);
+
+        outputFile << std::hex << std::setfill('0');
+        for (uint8_t byte : block) {
+            outputFile << std::setw(2) << (int)byte;
+        }
+        for (uint8_t byte : hash) {
+            outputFile << std::setw(2) << (int)byte;
+        }
+        outputFile << "\n";
+    }
+}
+
+// MD5 of an open file, read 1 MiB at a time
+bool md5File(int fd, uint8_t* digest) {
+    std::vector<uint8_t> buffer(1 << 20);
+    MD5Context ctx;
+    md5Init(ctx);
+
+    ssize_t n;
+    while ((n = read(fd, buffer.data(), buffer.size())) > 0) {
+        md5Update(ctx, buffer.data(), n);
+    }
+    if (n < 0) return false;
+
+    std::array<uint8_t, 16> hash = md5Final(ctx);
+    std::copy(hash.begin(), hash.end(), digest);
+    return true;
+}
+
+// Print md5sum-style lines for the files, taking the digests of unchanged files from the cache
+int hashFiles(const std::vector<std::string>& paths, const std::string& cachePath) {
+    DigestCache cache;
+    if (!cachePath.empty() && !cache.open(cachePath, "md5", 16)) {
+        std::cerr << "Could not open digest cache " << cachePath << "\n";
+        return 1;
+    }
+
+    int status = 0;
+    for (const std::string& path : paths) {
+        uint8_t digest[16];
+        bool hit;
+        if (!hashFileCached(path, cachePath.empty() ? nullptr : &cache, md5File, digest, hit)) {
+            std::cerr << "md5_cpp: " << path << ": cannot read\n";
+            status = 1;
+            continue;
+        }
+
+        for (uint8_t byte : digest) {
+            std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
+        }
+        std::cout << std::dec << "  " << path << "\n";
+    }
+    return status;
+}
+
+// Rescan a tree of files after changing a growing fraction of them: with the cache, the rescan time
+// should follow the number of changed files rather than the size of the tree
+void runCacheBenchmark() {
+    const std::string dir = "md5_cache_bench";
+    const std::string cachePath = dir + "/digests.cache";
+    const int fileCount = 2000;
+    const size_t fileSize = 256 << 10;
+    std::mt19937 rng(4120);
+
+    mkdir(dir.c_str(), 0755);
+    std::vector<std::string> paths;
+    std::vector<uint8_t> content(fileSize);
+    auto writeFile = [&](const std::string& path) {
+        for (uint8_t& byte : content) byte = rng();
+        std::ofstream(path, std::ios::binary).write((const char*) content.data(), content.size());
+
+        // Changes made earlier in the day, so the cache accepts them (see hashFileCached)
+        struct timespec times[2];
+        clock_gettime(CLOCK_REALTIME, &times[0]);
+        times[0].tv_sec -= 3600;
+        times[1] = times[0];
+        utimensat(AT_FDCWD, path.c_str(), times, 0);
+    };
+    for (int i = 0; i < fileCount; ++i) {
+        paths.push_back(dir + "/file" + std::to_string(i));
+        writeFile(paths.back());
+    }
+    std::remove(cachePath.c_str());
+
+    DigestCache cache;
+    cache.open(cachePath, "md5", 16);
+
+    std::cout << "Rescanning " << fileCount << " files of " << fileSize << " bytes\n";
+    for (int changed : {-1, 0, 20, 200, 1000, 2000}) {
+        // -1: the first scan, with an empty cache
+        for (int i = 0; i < changed; ++i) writeFile(paths[rng() % fileCount]);
+
+        int hashed = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const std::string& path : paths) {
+            uint8_t digest[16];
+            bool hit;
+            hashFileCached(path, &cache, md5File, digest, hit);
+            hashed += !hit;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = end - start;
+
+        std::cout << (changed < 0 ? std::string("first scan") : std::to_string(changed) + " changed") << ": "
+                  << hashed << " files hashed in " << diff.count() * 1e3 << " ms\n";
+    }
+
+    for (const std::string& path : paths) std::remove(path.c_str());
+    std::remove(cachePath.c_str());
+    rmdir(dir.c_str());
+}
+
+// Verify the same manifest with GNU md5sum -c and with checkManifest, which hashes files in extent
+// order on a thread pool. Drop the page cache between runs (as root) to compare cold reads.
+void runManifestBenchmark() {
+    const std::string dir = "md5_manifest_bench";
+    const std::string manifestPath = dir + "/manifest.md5";
+    const int fileCount = 1000;
+    const size_t fileSize = 256 << 10;
+    std::mt19937 rng(4120);
+
+    mkdir(dir.c_str(), 0755);
+    std::vector<std::string> paths;
+    std::vector<uint8_t> content(fileSize);
+    std::ofstream manifest(manifestPath);
+    for (int i = 0; i < fileCount; ++i) {
+        paths.push_back(dir + "/file" + std::to_string(i));
+        for (uint8_t& byte : content) byte = rng();
+        std::ofstream(paths.back(), std::ios::binary).write((const char*) content.data(), content.size());
+
+        std::array<uint8_t, 16> hash = calculate(std::string(content.begin(), content.end()));
+        for (uint8_t byte : hash) manifest << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
+        manifest << std::dec << "  " << paths.back() << "\n";
+    }
+    manifest.close();
+
+    std::cout << "Verifying " << fileCount << " files of " << fileSize << " bytes\n";
+    for (int run = 0; run < 2; ++run) {
+        auto start = std::chrono::high_resolution_clock::now();
+        int status = std::system(("md5sum -c --quiet " + manifestPath).c_str());
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> gnu = end - start;
+
+        ManifestOptions options;
+        options.quiet = true;
+        start = std::chrono::high_resolution_clock::now();
+        size_t failures = checkManifest(manifestPath, 16, md5File, "md5_cpp", options, std::cout);
+        end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> ours = end - start;
+
+        std::cout << "md5sum -c: " << gnu.count() * 1e3 << " ms" << (status == 0 ? "" : " (FAILED)")
+                  << ", md5_cpp -c: " << ours.count() * 1e3 << " ms" << (failures == 0 ? "" : " (FAILED)") << "\n";
+    }
+
+    for (const std::string& path : paths) std::remove(path.c_str());
+    std::remove(manifestPath.c_str());
+    rmdir(dir.c_str());
+}
+
+// Nanoseconds per hash of short keys: the general block loop, the run-time length path and the
+// compile-time length path
+template<size_t N>
+void runShortBenchmarkLength() {
+    const int executions = 2000000;
+    uint8_t key[N + 1] = {0};
+    uint32_t sink = 0;
+
+    auto time = [&](auto hashKey) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < executions; ++i) {
+            key[0] = (uint8_t) i;  // A different key every time, so that nothing is hoisted out of the loop
+            sink += hashKey()[0];
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        return diff.count() * 1e9 / executions;
+    };
+
+    double general = time([&] {
+        MD5Context ctx;
+        md5Init(ctx);
+        md5Update(ctx, key, N);
+        return md5Final(ctx);
+    });
+    double runtime = time([&] { return md5Short(key, N); });
+    double fixed = time([&] { return md5Fixed<N>(key); });
+
+    std::cout << std::setw(3) << N << " bytes: general " << general << " ns, md5Short " << runtime
+              << " ns, md5Fixed " << fixed << " ns" << (sink == 1 ? " " : "") << "\n";
+}
+
+void runShortBenchmark() {
+    runShortBenchmarkLength<0>();
+    runShortBenchmarkLength<16>();
+    runShortBenchmarkLength<32>();
+    runShortBenchmarkLength<55>();
+    runShortBenchmarkLength<64>();
+    runShortBenchmarkLength<100>();
+    runShortBenchmarkLength<119>();
+}
+
+
+int main(int argc, char** argv) {
+    // md5_cpp --vectors <file> <count> writes test vectors for the Verilog testbenches
+    if (argc == 4 && std::string(argv[1]) == "--vectors") {
+        writeTestVectors(argv[2], std::stoi(argv[3]));
+        return 0;
+    }
+
+    // md5_cpp [--cache <file>] <file>... hashes files, reusing the cached digests of unchanged ones
+    // md5_cpp -c [--quiet] [--fail-fast] [-j <threads>] [--cache <file>] <manifest> verifies a manifest
+    if (argc >= 2) {
+        std::string cachePath;
+        std::vector<std::string> paths;
+        bool check = false;
+        ManifestOptions options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--cache" && i + 1 < argc) cachePath = argv[++i];
+            else if (arg == "-c" || arg == "--check") check = true;
+            else if (arg == "--quiet") options.quiet = true;
+            else if (arg == "--fail-fast") options.failFast = true;
+            else if (arg == "-j" && i + 1 < argc) options.threads = std::stoi(argv[++i]);
+            else paths.push_back(arg);
+        }
+        if (!check) return hashFiles(paths, cachePath);
+
+        DigestCache cache;
+        if (!cachePath.empty()) {
+            if (!cache.open(cachePath, "md5", 16)) {
+                std::cerr << "Could not open digest cache " << cachePath << "\n";
+                return 1;
+            }
+            options.cache = &cache;
+        }
+        size_t failures = 0;
+        for (const std::string& manifest : paths.empty() ? std::vector<std::string>{"-"} : paths) {
+            failures += checkManifest(manifest, 16, md5File, "md5_cpp", options, std::cout);
+        }
+        return failures > 0 ? 1 : 0;
+    }
+
+    // Run the tests
+    // runTests();
+
+    // Snapshot a long stream and resume from the snapshot
+    // runCheckpointTests();
+
+    // Rescan a tree of files with the digest cache
+    // runCacheBenchmark();
+
+    // Verify a manifest against GNU md5sum -c
+    // runManifestBenchmark();
+
+    // Time the length-specialised paths for short keys
+    // runShortBenchmark();
+
+    // Run verification test
+    singleTest();
+
+    return 0;
+}
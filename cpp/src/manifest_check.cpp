@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "manifest_check.h"
+
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+enum EntryStatus { Pending, Ok, Mismatch, Unreadable, Skipped };
+
+struct ManifestEntry {
+    std::string path;
+    std::vector<uint8_t> expected;
+    uint64_t device = 0;
+    uint64_t physical = 0;  // Byte offset of the first extent on the device, or the inode number
+    int status = Pending;   // Written and read under the done mutex
+};
+
+static int hexValue(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+// "<hex>  <path>" or "<hex> *<path>"; a leading backslash marks a path with \\ and \n escapes
+static bool parseLine(std::string line, size_t digestLength, ManifestEntry& entry) {
+    bool escaped = !line.empty() && line[0] == '\\';
+    if (escaped) line.erase(0, 1);
+    if (line.size() < digestLength * 2 + 3 || line[digestLength * 2] != ' ') return false;
+
+    entry.expected.resize(digestLength);
+    for (size_t i = 0; i < digestLength; i++) {
+        int hi = hexValue(line[2 * i]), lo = hexValue(line[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        entry.expected[i] = (uint8_t) (hi << 4 | lo);
+    }
+
+    char mode = line[digestLength * 2 + 1];
+    if (mode != ' ' && mode != '*') return false;
+    std::string path = line.substr(digestLength * 2 + 2);
+
+    if (escaped) {
+        std::string unescaped;
+        for (size_t i = 0; i < path.size(); i++) {
+            if (path[i] == '\\' && i + 1 < path.size()) {
+                i++;
+                unescaped += (path[i] == 'n') ? '\n' : path[i];
+            } else {
+                unescaped += path[i];
+            }
+        }
+        path = unescaped;
+    }
+    entry.path = path;
+    return !path.empty();
+}
+
+// Where the file starts on disk: FIEMAP where the filesystem supports it, else the inode number,
+// which most filesystems allocate close to the data of files created together
+static void locate(ManifestEntry& entry) {
+    int fd = open(entry.path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        entry.device = st.st_dev;
+        entry.physical = st.st_ino;
+    }
+
+#ifdef __linux__
+    alignas(8) uint8_t request[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+    auto* map = (struct fiemap*) request;
+    map->fm_length = ~0ULL;
+    map->fm_extent_count = 1;
+    if (ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0) {
+        entry.physical = map->fm_extents[0].fe_physical;
+    }
+#endif
+    close(fd);
+}
+
+size_t checkManifest(const std::string& manifestPath, size_t digestLength,
+                     const std::function<bool(int, uint8_t*)>& hashFd, const std::string& toolName,
+                     const ManifestOptions& options, std::ostream& out) {
+    std::ifstream file;
+    if (manifestPath != "-") {
+        file.open(manifestPath);
+        if (!file) {
+            std::cerr << toolName << ": " << manifestPath << ": No such file or directory\n";
+            return 1;
+        }
+    }
+    std::istream& manifest = (manifestPath == "-") ? std::cin : file;
+
+    std::vector<ManifestEntry> entries;
+    size_t malformed = 0;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        entries.emplace_back();
+        if (!parseLine(line, digestLength, entries.back())) {
+            entries.pop_back();
+            malformed++;
+        }
+    }
+
+    for (ManifestEntry& entry : entries) locate(entry);
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (entries[a].device != entries[b].device) return entries[a].device < entries[b].device;
+        return entries[a].physical < entries[b].physical;
+    });
+
+    std::mutex doneMutex;
+    std::condition_variable done;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> firstFailure{SIZE_MAX};  // Manifest index, for failFast
+
+    auto worker = [&] {
+        std::vector<uint8_t> digest(digestLength);
+        while (true) {
+            size_t k = next++;
+            if (k >= order.size()) break;
+            size_t i = order[k];
+            ManifestEntry& entry = entries[i];
+
+            int status;
+            bool hit;
+            if (options.failFast && i > firstFailure) {
+                status = Skipped;
+            } else if (!hashFileCached(entry.path, options.cache, hashFd, digest.data(), hit)) {
+                status = Unreadable;
+            } else {
+                status = (digest == entry.expected) ? Ok : Mismatch;
+            }
+
+            if (status == Unreadable || status == Mismatch) {
+                size_t seen = firstFailure;
+                while (i < seen && !firstFailure.compare_exchange_weak(seen, i)) {
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(doneMutex);
+            entry.status = status;
+            done.notify_one();
+        }
+    };
+
+    unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; t++) pool.emplace_back(worker);
+
+    // Report in manifest order while the pool works ahead
+    size_t mismatches = 0, unreadable = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        int status;
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait(lock, [&] { return entries[i].status != Pending; });
+            status = entries[i].status;
+        }
+
+        if (status == Skipped) break;
+        if (status == Ok) {
+            if (!options.quiet) out << entries[i].path << ": OK\n";
+        } else if (status == Mismatch) {
+            out << entries[i].path << ": FAILED\n";
+            mismatches++;
+        } else {
+            std::cerr << toolName << ": " << entries[i].path << ": No such file or directory\n";
+            out << entries[i].path << ": FAILED open or read\n";
+            unreadable++;
+        }
+        out.flush();
+
+        if (options.failFast && status != Ok) {
+            next = order.size();  // Nothing new starts; running hashes finish
+            break;
+        }
+    }
+    for (std::thread& t : pool) t.join();
+
+    if (malformed > 0) {
+        std::cerr << toolName << ": WARNING: " << malformed << " line" << (malformed > 1 ? "s are" : " is")
+                  << " improperly formatted\n";
+    }
+    if (unreadable > 0) {
+        std::cerr << toolName << ": WARNING: " << unreadable << " listed file" << (unreadable > 1 ? "s" : "")
+                  << " could not be read\n";
+    }
+    if (mismatches > 0) {
+        std::cerr << toolName << ": WARNING: " << mismatches << " computed checksum"
+                  << (mismatches > 1 ? "s" : "") << " did NOT match\n";
+    }
+    return mismatches + unreadable + (entries.empty() && malformed > 0 ? 1 : 0);
+}
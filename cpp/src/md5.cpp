@@ -6,49 +6,16 @@
  * Description: Various implementations of the MD5 hashing algorithm. This implementation is based on the MD5 algorithm described in RFC 1321. This also solely focuses on the C++ implementation of the MD5 algorithm.
  */
 
-#include <fstream>
-#include <iostream>
-#include <vector>
-#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "md5.h"
+#include "md5_short.h"
 
 // Define a typedef for a function pointer that takes three uint32_t and returns a uint32_t
 typedef uint32_t (*FuncPtr)(uint32_t, uint32_t, uint32_t);
 
-// The rotation amounts for each round
-static const constexpr uint32_t S[64] = {
-        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
-        5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
-        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
-        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
-};
-
-// The constants for each round
-static const constexpr uint32_t K[64] = {
-        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
-        0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
-        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
-        0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
-        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
-        0xd62f105d, 0x2441453, 0xd8a1e681, 0xe7d3fbc8,
-        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
-        0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
-        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
-        0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
-        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x4881d05,
-        0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
-        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
-        0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
-        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
-        0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
-};
-
-// The g values for each round
-static const constexpr uint32_t g_values[64] = {
-        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, // for j <= 15
-        1, 6, 11, 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, // for j <= 31
-        5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2, // for j <= 47
-        0, 7, 14, 5, 12, 3, 10, 1, 8, 15, 6, 13, 4, 11, 2, 9  // for j <= 63
-};
+// The rotation amounts, constants and g values for each round are md5S, md5K and md5G in md5_short.h
 
 uint32_t a0 = 0x67452301; // Initial value of 'a' where 'a' is a 32-bit word.
 uint32_t b0 = 0xefcdab89; // Initial value of 'b' where 'b' is a 32-bit word.
@@ -78,8 +45,118 @@ inline uint32_t I(uint32_t x, uint32_t y, uint32_t z) {
 // Define the lookup table
 FuncPtr funcTable[4] = {F, G, H, I};
 
+// Process one 64-byte block, updating the chaining values state = {A, B, C, D}
+static void processBlock(uint32_t state[4], const uint8_t* block) {
+    // Break chunk into sixteen 32-bit words M[j], 0 ≤ j ≤ 15
+    uint32_t M[16];
+    for (int j = 0; j < 16; ++j) {
+        M[j] = (block[j*4 + 3] << 24) | (block[j*4 + 2] << 16) | (block[j*4 + 1] << 8) | block[j*4];
+    }
+
+    // Initialize hash value for this chunk
+    // Note: The following are copies of A, B, C, D which initially are set to a0, b0, c0, and d0 respectively for the first chunk.
+    uint32_t AA = state[0];
+    uint32_t BB = state[1];
+    uint32_t CC = state[2];
+    uint32_t DD = state[3];
+
+    // Main loop
+    for (int j = 0; j < 64; j += 4) {
+        uint32_t tempF[4], g[4], tempShift[4];
+
+        // Loop unrolling to reduce overhead of loop control and increase instruction-level parallelism
+        for (int k = 0; k < 4; ++k) {
+            int index = (j + k) >> 4;
+
+            // Call the appropriate function using the lookup table
+            tempF[k] = funcTable[index](BB, CC, DD);
+
+            g[k] = md5G[j + k];
+
+            tempF[k] = tempF[k] + AA + md5K[j + k] + M[g[k]]; // Note: Addition may overflow, which is fine
+            tempShift[k] = (tempF[k] << md5S[j + k]) | (tempF[k] >> (32 - md5S[j + k])); // Store the result of the bitwise operation in a temporary variable
+            AA = DD;
+            DD = CC;
+            CC = BB;
+            BB += tempShift[k]; // Use the stored result
+        }
+    }
+
+    // Add this chunk's hash to result so far
+    state[0] += AA;
+    state[1] += BB;
+    state[2] += CC;
+    state[3] += DD;
+}
+
+static inline uint32_t loadWord(const uint8_t* p) {
+    return (p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+}
+
+// Last block of a short message, where only the first W words can hold message bytes or the 0x80
+// byte and words 14 and 15 hold the length: the zero words in between are constants
+template<int W>
+static void md5ShortFinalBlock(uint32_t state[4], const uint8_t* block) {
+    uint32_t M[16];
+#pragma GCC unroll 16
+    for (int j = 0; j < 16; ++j) {
+        M[j] = (j < W || j >= 14) ? loadWord(block + j * 4) : 0;
+    }
+    md5CompressWords(state, M);
+}
+
+typedef void (*FinalBlockFn)(uint32_t*, const uint8_t*);
+
+template<size_t... W>
+static constexpr std::array<FinalBlockFn, sizeof...(W)> finalBlockTable(std::index_sequence<W...>) {
+    return {md5ShortFinalBlock<W>...};
+}
+
+static constexpr std::array<FinalBlockFn, 15> finalBlocks = finalBlockTable(std::make_index_sequence<15>());
+
+std::array<uint8_t, 16> md5Short(const uint8_t* data, size_t length) {
+    // Longer messages do not fit in two blocks with their padding
+    if (length > 119) {
+        MD5Context ctx;
+        md5Init(ctx);
+        md5Update(ctx, data, length);
+        return md5Final(ctx);
+    }
+
+    // Message, 0x80, zeros and the length in a stack buffer of one or two blocks
+    uint8_t block[128] = {0};
+    size_t blocks = (length + 8) / 64 + 1;
+    memcpy(block, data, length);
+    block[length] = 0x80;
+    uint64_t bitLen = (uint64_t) length * 8;
+    for (int i = 0; i < 8; ++i) {
+        block[blocks * 64 - 8 + i] = (uint8_t) (bitLen >> (i * 8));
+    }
+
+    uint32_t state[4] = {md5IV[0], md5IV[1], md5IV[2], md5IV[3]};
+    const uint8_t* last = block;
+    if (blocks == 2) {
+        uint32_t M[16];
+        for (int j = 0; j < 16; ++j) M[j] = loadWord(block + j * 4);
+        md5CompressWords(state, M);
+        last = block + 64;
+    }
+
+    // Words of the last block that can be non-zero before the length: none when the 0x80 byte
+    // ended the first block
+    size_t inLast = length - (blocks - 1) * 64;
+    int W = (length < 64 && blocks == 2) ? 0 : (int) (inLast / 4 + 1);
+    finalBlocks[W](state, last);
+
+    return md5StateBytes(state);
+}
+
 // Calculate the MD5 hash of the input message
 std::array<uint8_t, 16> calculate(const std::string& inputStr) {
+    if (inputStr.size() <= 119) {
+        return md5Short((const uint8_t*) inputStr.data(), inputStr.size());
+    }
+
     std::vector<uint8_t> input(inputStr.begin(), inputStr.end());
     uint64_t bitLen = input.size() * 8; // original length in bits
 
@@ -104,48 +181,14 @@ std::array<uint8_t, 16> calculate(const std::string& inputStr) {
     uint32_t D = d0;
 
     // Step 5: Process Message in 16-Word Blocks
+    uint32_t state[4] = {A, B, C, D};
     for (size_t i = 0; i < input.size(); i += 64) {
-        // Break chunk into sixteen 32-bit words M[j], 0 ≤ j ≤ 15
-        uint32_t M[16];
-        for (int j = 0; j < 16; ++j) {
-            M[j] = (input[i + j*4 + 3] << 24) | (input[i + j*4 + 2] << 16) | (input[i + j*4 + 1] << 8) | input[i + j*4];
-        }
-
-        // Initialize hash value for this chunk
-        // Note: The following are copies of A, B, C, D which initially are set to a0, b0, c0, and d0 respectively for the first chunk.
-        uint32_t AA = A;
-        uint32_t BB = B;
-        uint32_t CC = C;
-        uint32_t DD = D;
-
-        // Main loop
-        for (int j = 0; j < 64; j += 4) {
-            uint32_t tempF[4], g[4], tempShift[4];
-
-            // Loop unrolling to reduce overhead of loop control and increase instruction-level parallelism
-            for (int k = 0; k < 4; ++k) {
-                int index = (j + k) >> 4;
-
-                // Call the appropriate function using the lookup table
-                tempF[k] = funcTable[index](BB, CC, DD);
-
-                g[k] = g_values[j + k];
-
-                tempF[k] = tempF[k] + AA + K[j + k] + M[g[k]]; // Note: Addition may overflow, which is fine
-                tempShift[k] = (tempF[k] << S[j + k]) | (tempF[k] >> (32 - S[j + k])); // Store the result of the bitwise operation in a temporary variable
-                AA = DD;
-                DD = CC;
-                CC = BB;
-                BB += tempShift[k]; // Use the stored result
-            }
-        }
-
-        // Add this chunk's hash to result so far
-        A += AA;
-        B += BB;
-        C += CC;
-        D += DD;
+        processBlock(state, &input[i]);
     }
+    A = state[0];
+    B = state[1];
+    C = state[2];
+    D = state[3];
 
     // Step 6: Output
     // The final result is the MD5 hash of the input message
@@ -160,70 +203,114 @@ std::array<uint8_t, 16> calculate(const std::string& inputStr) {
     return result;
 }
 
-void runTests() {
-    int executions = 100;
-    std::vector<double> times(executions, 0); // Vector to store all execution times
-
-    // Loop over different input sizes
-    for (unsigned long long inputSize = 0; inputSize <= pow(2, 23); inputSize += 4 * ceil(pow(2, 23) / 400)) {
-        // Generate input string of the required size
-        std::string inputS(inputSize, 'a'); // Fill the string with 'a'
-
-        std::cout << "Running " << executions << " executions of MD5 hashing on input size " << inputSize << "\n";
+void md5Init(MD5Context& ctx) {
+    ctx.A = a0;
+    ctx.B = b0;
+    ctx.C = c0;
+    ctx.D = d0;
+    ctx.length = 0;
+    ctx.bufferLen = 0;
+}
 
-        for (int i = 0; i < executions; ++i) {
-            auto start = std::chrono::high_resolution_clock::now();
+void md5Update(MD5Context& ctx, const uint8_t* data, size_t len) {
+    uint32_t state[4] = {ctx.A, ctx.B, ctx.C, ctx.D};
+    ctx.length += len;
+
+    // Complete a partially filled block first
+    if (ctx.bufferLen > 0) {
+        size_t take = std::min(len, 64 - ctx.bufferLen);
+        memcpy(ctx.buffer + ctx.bufferLen, data, take);
+        ctx.bufferLen += take;
+        data += take;
+        len -= take;
+
+        if (ctx.bufferLen < 64) return;
+        processBlock(state, ctx.buffer);
+        ctx.bufferLen = 0;
+    }
 
-            std::array<uint8_t, 16> hash = calculate(inputS);
+    // Whole blocks are processed straight from the input
+    for (; len >= 64; data += 64, len -= 64) {
+        processBlock(state, data);
+    }
 
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double> diff = end - start;
+    memcpy(ctx.buffer, data, len);
+    ctx.bufferLen = len;
 
-            times[i] = diff.count(); // Store execution time in vector
-        }
+    ctx.A = state[0];
+    ctx.B = state[1];
+    ctx.C = state[2];
+    ctx.D = state[3];
+}
 
-        // Write the execution times to a CSV file
-        std::ofstream outputFile("execution_times.csv", std::ios_base::app); // Append to the file
-        if (inputSize == 0) {
-            outputFile << "Run Number,Message Size,Execution Time\n"; // Write the headers
-        }
-        for (int i = 0; i < executions; ++i) {
-            outputFile << i+1 << "," << inputSize << "," << times[i] << "\n";
-        }
-        outputFile.close();
+std::array<uint8_t, 16> md5Final(MD5Context& ctx) {
+    uint64_t bitLen = ctx.length * 8;
+    uint32_t state[4] = {ctx.A, ctx.B, ctx.C, ctx.D};
 
-        // Clear the vector
-        times.clear();
+    // Append the '1' bit, zero-pad to 56 bytes modulo 64 and append the length
+    uint8_t padding[128] = {0x80};
+    size_t padLen = (ctx.bufferLen < 56) ? 64 - ctx.bufferLen : 128 - ctx.bufferLen;
+    for (int i = 0; i < 8; ++i) {
+        padding[padLen - 8 + i] = bitLen >> (i * 8);
     }
-}
 
-void singleTest() {
-    std::string input = "The quick brown fox jumps over the lazy dog";
+    memcpy(ctx.buffer + ctx.bufferLen, padding, 64 - ctx.bufferLen);
+    processBlock(state, ctx.buffer);
+    if (padLen > 64 - ctx.bufferLen) {
+        processBlock(state, padding + (64 - ctx.bufferLen));
+    }
 
-    auto start = std::chrono::high_resolution_clock::now();
+    std::array<uint8_t, 16> result;
+    for (int i = 0; i < 4; ++i) {
+        result[i]     = (uint8_t)(state[0] >> (i * 8));
+        result[i + 4] = (uint8_t)(state[1] >> (i * 8));
+        result[i + 8] = (uint8_t)(state[2] >> (i * 8));
+        result[i + 12] = (uint8_t)(state[3] >> (i * 8));
+    }
 
-    std::array<uint8_t, 16> hash = calculate(input);
+    return result;
+}
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> diff = end - start;
+// Snapshot layout (little-endian): A, B, C, D, length in bytes, then the length % 64 buffered bytes
+std::vector<uint8_t> md5Snapshot(const MD5Context& ctx) {
+    std::vector<uint8_t> snapshot(4 * 4 + 8 + ctx.bufferLen);
+    uint32_t words[4] = {ctx.A, ctx.B, ctx.C, ctx.D};
 
-    std::cout << "MD5 hash of '" << input << "': ";
-    for (uint8_t byte : hash) {
-        std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            snapshot[i * 4 + j] = (uint8_t)(words[i] >> (j * 8));
+        }
     }
-    std::cout << "\n";
-    // Expected hash: 9e107d9d372bb6826bd81d3542a419d6
+    for (int j = 0; j < 8; ++j) {
+        snapshot[16 + j] = (uint8_t)(ctx.length >> (j * 8));
+    }
+    memcpy(snapshot.data() + 24, ctx.buffer, ctx.bufferLen);
 
-    std::cout << "Execution time: " << diff.count() << " s\n";
+    return snapshot;
 }
 
+bool md5Restore(MD5Context& ctx, const std::vector<uint8_t>& snapshot) {
+    if (snapshot.size() < 24) return false;
 
-int main() {
-    // Run the tests
-    // runTests();
+    uint32_t words[4] = {0, 0, 0, 0};
+    uint64_t length = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            words[i] |= (uint32_t) snapshot[i * 4 + j] << (j * 8);
+        }
+    }
+    for (int j = 0; j < 8; ++j) {
+        length |= (uint64_t) snapshot[16 + j] << (j * 8);
+    }
+    if (snapshot.size() != 24 + length % 64) return false;
 
-    // Run verification test
-    singleTest();
+    ctx.A = words[0];
+    ctx.B = words[1];
+    ctx.C = words[2];
+    ctx.D = words[3];
+    ctx.length = length;
+    ctx.bufferLen = length % 64;
+    memcpy(ctx.buffer, snapshot.data() + 24, ctx.bufferLen);
 
-    return 0;
+    return true;
 }
@@ -0,0 +1,21 @@
+#ifndef EEE4120F_YODA_MD5_SIMD_H
+#define EEE4120F_YODA_MD5_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Multi-buffer MD5: independent messages are hashed side by side, one per vector lane, so the
+// sequential dependency inside each message no longer limits throughput.
+
+// Lanes of the widest instruction set this CPU supports (8 with AVX2, 4 with SSE2), 0 without SIMD
+int md5SimdLanes();
+
+// Hash count messages, md5SimdLanes() at a time; digests holds 16 bytes per message.
+// Must only be called when md5SimdLanes() is non-zero. Groups of messages that all have the same
+// length of at most md5ShortLaneMax bytes are hashed as a single block with the padding and length
+// words as constants.
+static const size_t md5ShortLaneMax = 55;
+
+void md5BatchSIMD(const uint8_t* const* messages, const size_t* lengths, size_t count, uint8_t* digests);
+
+#endif //EEE4120F_YODA_MD5_SIMD_H
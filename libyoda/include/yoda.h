@@ -0,0 +1,98 @@
+#ifndef EEE4120F_YODA_YODA_H
+#define EEE4120F_YODA_YODA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Single entry point to the MD5 and MD6 implementations of this repository. Every call picks an engine
+// at runtime from the CPU features, the OpenCL devices present and the size of the work, unless one is
+// forced with setEngine().
+namespace yoda {
+
+enum class Algorithm { MD5, MD6 };
+
+enum class Engine {
+    Auto,      // Let the dispatcher decide
+    Scalar,    // Portable C++: calculate()/md5Update() and md6_update()
+    SIMD,      // Multi-buffer MD5, one message per vector lane (SSE2 or AVX2)
+    Threaded,  // MD6 tree levels and batches spread over all cores (md6_tree, md6_batch)
+    OpenCL,    // MD6 tree levels compressed on the OpenCL device
+    Hybrid     // A batch split between the threaded CPU path and the OpenCL device
+};
+
+typedef std::vector<uint8_t> Digest;
+
+// MD6 digest size in bits used by the calls below
+static const int md6DigestBits = 256;
+
+// Crossover points of the dispatcher, measured by calibrate() for the CPU and device of a machine.
+// The defaults are used until a profile is loaded; the library loads the file named by the
+// YODA_PROFILE environment variable on first use.
+struct Profile {
+    std::string device;                      // OpenCL device the profile was measured with, empty for none
+    uint64_t md6ThreadedMinBytes = 1 << 20;  // One MD6 message: threaded tree from this size
+    uint64_t md6OpenCLMinBytes = 64 << 20;   // One MD6 message: device from this size
+    size_t md5SimdMinBatch = 8;              // MD5 batches: multi-buffer from this many messages
+    size_t md6ThreadedMinBatch = 16;         // MD6 batches: worker threads from this many messages
+    double md6CpuBytesPerSecond = 0;         // Threaded MD6 throughput on large messages (splits hybrid batches)
+    double md6OpenCLBytesPerSecond = 0;      // Device MD6 throughput on large messages, 0 without a device
+};
+
+Profile profile();
+void setProfile(const Profile& profile);
+
+// Time every engine over a range of message and batch sizes and derive the crossover points
+Profile calibrate();
+
+// Text file of "key value" lines. loadProfile rejects a profile measured with another OpenCL device.
+bool saveProfile(const std::string& path, const Profile& profile);
+bool loadProfile(const std::string& path);
+
+// One message
+Digest hash(Algorithm alg, const uint8_t* data, size_t length);
+Digest hash(Algorithm alg, const std::string& data);
+
+// Many independent messages, digests in the same order
+std::vector<Digest> hashBatch(Algorithm alg, const std::vector<std::string>& messages);
+std::vector<Digest> hashBatch(Algorithm alg, const uint8_t* const* messages, const size_t* lengths, size_t count);
+
+// Messages that arrive in pieces
+class Hasher {
+public:
+    explicit Hasher(Algorithm alg);
+    ~Hasher();
+    void update(const uint8_t* data, size_t length);
+    void update(const std::string& data);
+    Digest final();
+
+private:
+    struct State;  // MD5Context or md6_state, kept out of this header (md6.h defines a min macro)
+    Algorithm alg;
+    std::unique_ptr<State> state;
+};
+
+// Diagnostics: what the machine offers and what the dispatcher chose
+struct Features {
+    bool sse2;
+    bool avx2;
+    bool opencl;          // An OpenCL device was found and the MD6 kernels built
+    unsigned int cores;
+    std::string device;   // OpenCL device name, empty without one
+};
+
+const Features& features();
+Engine selectEngine(Algorithm alg, uint64_t length, size_t count = 1);
+Engine lastEngine();  // Engine of the last call on this thread
+const char* engineName(Engine engine);
+std::string toHex(const Digest& digest);
+
+// Force an engine for the following calls on all threads (Engine::Auto restores the dispatcher).
+// An engine that cannot run the request falls back to the dispatcher's choice.
+void setEngine(Engine engine);
+
+}
+
+#endif //EEE4120F_YODA_YODA_H
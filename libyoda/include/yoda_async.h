@@ -0,0 +1,200 @@
+#ifndef EEE4120F_YODA_YODA_ASYNC_H
+#define EEE4120F_YODA_YODA_ASYNC_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "yoda.h"
+
+// Coroutine API for event-loop services (C++20, the rest of the library stays on C++17).
+// co_await hashFileAsync(...) or hashBatchAsync(...) suspends the calling coroutine while the work
+// runs on a worker pool, and resumes it on the loop thread when the work is done. The loop thread
+// never waits on the work: workers hand finished coroutines back through a pipe that the loop polls.
+namespace yoda {
+
+template<typename T> class Task;
+
+// Task<T>: a coroutine that starts when it is awaited (or spawned) and resumes its awaiter on completion
+struct TaskFinal {
+    bool await_ready() const noexcept { return false; }
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        return handle.promise().continuation;
+    }
+    void await_resume() const noexcept {}
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    TaskFinal final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+    Task<T> get_return_object();
+    void return_value(T result) { value = std::move(result); }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+template<typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    T await_resume() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+        if constexpr (!std::is_void_v<T>) return std::move(*handle.promise().value);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Resumes coroutines on the thread that calls run() or runReady()
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+
+    // Readable while coroutines are waiting to be resumed, for services that poll their own descriptors
+    int fd() const { return pipeFds[0]; }
+    void runReady();
+
+    // Resume coroutines until every spawned task has finished; rethrows the first exception of one
+    void run();
+
+    // Start a task that nothing awaits
+    void spawn(Task<void> task);
+
+    // Queue a coroutine to be resumed on the loop thread; callable from any thread
+    void post(std::coroutine_handle<> handle);
+
+    size_t active() const { return spawned; }
+
+private:
+    friend struct SpawnedTask;
+    int pipeFds[2];
+    std::mutex mutex;
+    std::deque<std::coroutine_handle<>> ready;
+    size_t spawned;
+    std::exception_ptr firstError;
+};
+
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned int threads = 0);  // 0: one per core
+    ~WorkerPool();
+    void submit(std::function<void()> job);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    bool stopping;
+};
+
+// Shared between the caller and the tasks it started; cancel() makes the tasks stop at their next
+// chunk or slice and return empty results
+class CancelToken {
+public:
+    CancelToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+    void cancel() { flag->store(true); }
+    bool cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+// co_await offload(loop, pool, job): job() runs on the pool, its result is returned on the loop thread
+template<typename F>
+class Offload {
+public:
+    using Result = std::invoke_result_t<F>;
+
+    Offload(EventLoop& loop, WorkerPool& pool, F job) : loop(loop), pool(pool), job(std::move(job)) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        pool.submit([this, handle] {
+            try {
+                result.emplace(job());
+            } catch (...) {
+                error = std::current_exception();
+            }
+            loop.post(handle);
+        });
+    }
+    Result await_resume() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+
+private:
+    EventLoop& loop;
+    WorkerPool& pool;
+    F job;
+    std::optional<Result> result;
+    std::exception_ptr error;
+};
+
+template<typename F>
+Offload<F> offload(EventLoop& loop, WorkerPool& pool, F job) {
+    return Offload<F>(loop, pool, std::move(job));
+}
+
+// Digest of a file, read and hashed in chunks on the pool. Empty if the file cannot be read or the
+// token was cancelled.
+Task<Digest> hashFileAsync(EventLoop& loop, WorkerPool& pool, Algorithm alg, std::string path,
+                           CancelToken token = CancelToken());
+
+// Digests of messages, hashed as slices in parallel on the pool through the dispatcher. Empty if
+// the token was cancelled.
+Task<std::vector<Digest>> hashBatchAsync(EventLoop& loop, WorkerPool& pool, Algorithm alg,
+                                         std::vector<std::string> messages, CancelToken token = CancelToken());
+
+}
+
+#endif //EEE4120F_YODA_YODA_ASYNC_H
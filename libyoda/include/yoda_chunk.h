@@ -0,0 +1,73 @@
+#ifndef EEE4120F_YODA_YODA_CHUNK_H
+#define EEE4120F_YODA_YODA_CHUNK_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "yoda.h"
+
+// Content-defined chunking for deduplication. Boundaries come from a Gear rolling hash over the
+// data itself (FastCDC with normalised chunking), so an insertion only changes the chunks around it.
+namespace yoda {
+
+struct ChunkParams {
+    size_t minSize = 2 << 10;
+    size_t averageSize = 8 << 10;  // Power of two
+    size_t maxSize = 64 << 10;
+};
+
+class Chunker {
+public:
+    explicit Chunker(const ChunkParams& params = ChunkParams());
+
+    // Length of the chunk starting at data. When it returns length itself and more data follows,
+    // the boundary may lie further on: call again once maxSize bytes are available.
+    size_t cut(const uint8_t* data, size_t length) const;
+
+    const ChunkParams& params() const { return p; }
+
+private:
+    ChunkParams p;
+    uint64_t maskSmall;  // More bits below the average size, so short chunks are rare
+    uint64_t maskLarge;  // Fewer bits above it, so chunks rarely reach maxSize
+};
+
+// Digests of the chunks seen so far, kept in an append-only file of (length, digest) records
+class ChunkIndex {
+public:
+    ChunkIndex();
+    ~ChunkIndex();
+    bool open(const std::string& path, Algorithm alg);
+    void close();
+
+    // True if the chunk was new, in which case it is recorded
+    bool insert(const uint8_t* digest, uint32_t length);
+    size_t size() const { return seen.size(); }
+
+private:
+    FILE* file;
+    size_t digestLen;
+    std::unordered_set<std::string> seen;
+};
+
+struct DedupStats {
+    uint64_t bytes = 0;
+    uint64_t chunks = 0;
+    uint64_t uniqueBytes = 0;
+    uint64_t uniqueChunks = 0;
+    double seconds = 0;
+    bool ok = true;  // False if fd could not be read to its end, the chunks stop at the error
+
+    double ratio() const { return bytes ? (double) bytes / uniqueBytes : 1; }  // Infinite when nothing was new
+};
+
+// Read fd to the end, chunk it and hash the chunks where they lie in the read buffer. The next
+// window is read and chunked while the previous one is hashed, and results reach the index in
+// stream order.
+DedupStats dedupStream(int fd, Algorithm alg, ChunkIndex& index, const ChunkParams& params = ChunkParams());
+
+}
+
+#endif //EEE4120F_YODA_YODA_CHUNK_H
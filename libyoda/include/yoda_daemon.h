@@ -0,0 +1,50 @@
+#ifndef EEE4120F_YODA_YODA_DAEMON_H
+#define EEE4120F_YODA_YODA_DAEMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "yoda.h"
+
+// Wire format between yodad and its clients over a Unix domain socket. Both ends run on the same
+// machine, so the headers are sent in native byte order. A connection carries any number of
+// requests; the responses come back in the order the requests were sent.
+namespace yoda {
+
+static const char* const defaultSocketPath = "/tmp/yoda.sock";
+static const uint32_t maxRequestBytes = 64 << 20;
+
+struct RequestHeader {
+    uint8_t algorithm;  // 0 = MD5, 1 = MD6
+    uint8_t reserved[3];
+    uint32_t length;    // Message bytes following the header
+};
+
+struct ResponseHeader {
+    uint8_t status;     // 0 = ok, otherwise no digest follows
+    uint8_t length;     // Digest bytes following the header
+    uint8_t engine;     // Engine the daemon's batch ran on
+    uint8_t reserved;
+};
+
+// Read or write exactly length bytes, false if the peer went away
+bool readFull(int fd, void* data, size_t length);
+bool writeFull(int fd, const void* data, size_t length);
+
+// One connection to the daemon, for one thread at a time
+class DaemonClient {
+public:
+    DaemonClient();
+    ~DaemonClient();
+    bool connect(const std::string& path = defaultSocketPath);
+    bool hash(Algorithm alg, const uint8_t* data, size_t length, Digest& digest);
+    Engine lastEngine() const { return engine; }
+
+private:
+    int fd;
+    Engine engine;
+};
+
+}
+
+#endif //EEE4120F_YODA_YODA_DAEMON_H
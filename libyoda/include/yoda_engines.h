@@ -0,0 +1,34 @@
+#ifndef EEE4120F_YODA_YODA_ENGINES_H
+#define EEE4120F_YODA_YODA_ENGINES_H
+
+#include "yoda.h"
+
+// Engines behind the dispatcher, shared by yoda.cpp and the calibration in yoda_profile.cpp.
+// Both return the engine that actually ran, which differs from the requested one after a fallback.
+namespace yoda {
+
+Engine hashOne(Algorithm alg, Engine engine, const uint8_t* data, size_t length, uint8_t* digest);
+Engine hashMany(Algorithm alg, Engine engine, const uint8_t* const* messages, const size_t* lengths, size_t count,
+                uint8_t* digests);
+
+size_t digestLength(Algorithm alg);
+
+// Recording side of yoda_metrics.h. metricsStart returns the token metricsRecord expects: the calling
+// thread's counters, looked up once per call, and a timestamp. The counters are null when metrics are
+// off and for the short calls left out of the sample, which metricsRecord then skips.
+struct ThreadMetrics;
+struct MetricsToken {
+    ThreadMetrics* thread;
+    uint64_t start;
+};
+MetricsToken metricsStart(uint64_t bytes);
+void metricsRecord(MetricsToken token, Algorithm alg, Engine engine, size_t messages, uint64_t bytes);
+void metricsCompressions(uint64_t count);
+void metricsOpenCLTransfer(uint64_t toDevice, uint64_t fromDevice);
+
+// Compressions of one MD6 message in tree mode (the engines other than md6_update do not keep count)
+uint64_t md6TreeCompressions(uint64_t length);
+
+}
+
+#endif //EEE4120F_YODA_YODA_ENGINES_H
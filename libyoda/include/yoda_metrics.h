@@ -0,0 +1,51 @@
+#ifndef EEE4120F_YODA_YODA_METRICS_H
+#define EEE4120F_YODA_YODA_METRICS_H
+
+#include <cstdint>
+#include <string>
+#include "yoda.h"
+
+// Counters and latency histograms kept by hash(), hashBatch() and Hasher. Every thread records into
+// its own counters, so recording takes no lock; metrics() sums them over all threads.
+namespace yoda {
+
+// Log-linear histogram in the style of HdrHistogram: exact below 16 ns, then 16 sub-buckets per
+// power of two, so a value lands in a bucket at most 1/16 of itself wide. Values above 2^41 ns
+// (about 36 minutes) go to the last bucket.
+struct Histogram {
+    static const int buckets = 16 + 38 * 16;
+    uint64_t counts[buckets] = {};
+
+    static int bucketOf(uint64_t nanoseconds);
+    static uint64_t lowerBound(int bucket);
+    uint64_t count() const;
+    uint64_t quantile(double q) const;  // Nanoseconds, the middle of the bucket holding quantile q
+};
+
+// Calls under 4 KiB are sampled 1 in 256 per thread, and each sampled call counts 256 times, in the
+// histogram and the counters alike
+struct EngineMetrics {
+    Histogram latency;         // One observation per call
+    uint64_t calls = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t nanoseconds = 0;  // Sum of the recorded latencies, with the sampling weight
+};
+
+struct Metrics {
+    EngineMetrics engines[2][6];  // [Algorithm][Engine], the engine that actually ran
+    uint64_t md6Compressions = 0;
+    uint64_t openclBytesToDevice = 0;
+    uint64_t openclBytesFromDevice = 0;
+};
+
+Metrics metrics();
+void resetMetrics();
+void setMetricsEnabled(bool enabled);  // On by default
+
+// Prometheus text exposition format
+std::string metricsText();
+
+}
+
+#endif //EEE4120F_YODA_YODA_METRICS_H
@@ -0,0 +1,16 @@
+#ifndef EEE4120F_YODA_YODA_OPENCL_H
+#define EEE4120F_YODA_YODA_OPENCL_H
+
+#include <string>
+#include "md6.h"
+
+// OpenCL engine of libyoda, only built with `make OPENCL=1` (YODA_WITH_OPENCL). The kernels are read
+// from bin/Kernel.cl relative to the working directory, as in the opencl implementation.
+
+// Find a device and build the kernels once; false if there is no usable device
+bool yodaOpenCLProbe(std::string& device);
+
+// MD6 tree-mode hash of a byte-aligned message on the device; false if the device failed
+bool yodaOpenCLHashMD6(const unsigned char* data, uint64_t length, const md6_state* params, unsigned char* hashval);
+
+#endif //EEE4120F_YODA_YODA_OPENCL_H
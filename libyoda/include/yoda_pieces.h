@@ -0,0 +1,54 @@
+#ifndef EEE4120F_YODA_YODA_PIECES_H
+#define EEE4120F_YODA_YODA_PIECES_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "yoda.h"
+
+// Digests of the fixed-size pieces of a file, as a transfer system checks them (BitTorrent style).
+// Pieces are independent messages of equal length, which is what the multi-buffer MD5 engine wants:
+// each window of the file is split between the cores, and every core hashes its pieces a vector of
+// lanes at a time. Regular files are mapped one window at a time, anything else (pipes) is read, so
+// files larger than memory go through in bounded space.
+namespace yoda {
+
+struct PieceParams {
+    uint64_t pieceSize = 256 << 10;
+    uint64_t windowSize = 64 << 20;  // Rounded to whole pieces
+    unsigned int threads = 0;        // 0 for every core
+};
+
+struct PieceStats {
+    uint64_t bytes = 0;
+    uint64_t pieces = 0;
+    double seconds = 0;
+    bool mapped = false;  // The file was mapped rather than read
+    bool ok = true;       // False if a window could not be mapped or read, the pieces stop before it
+};
+
+// Receives the digests of pieces first .. first + count - 1, in file order
+typedef std::function<void(uint64_t first, const uint8_t* digests, size_t count)> PieceSink;
+
+PieceStats hashPieces(int fd, Algorithm alg, const PieceParams& params, const PieceSink& sink);
+
+// Piece table file: "YODAPCE1", the algorithm byte, the piece size and the file length (8 bytes each,
+// native-endian), then the digest of every piece in order
+struct PieceTable {
+    Algorithm alg = Algorithm::MD5;
+    uint64_t pieceSize = 0;
+    uint64_t length = 0;
+    std::vector<uint8_t> digests;
+
+    size_t count() const { return pieceSize ? (length + pieceSize - 1) / pieceSize : 0; }
+};
+
+// Hash fd into a piece table, the digests written as each window is done
+bool writePieceTable(int fd, const std::string& path, Algorithm alg, const PieceParams& params,
+                     PieceStats* stats = nullptr);
+bool loadPieceTable(const std::string& path, PieceTable& table);
+
+}
+
+#endif //EEE4120F_YODA_YODA_PIECES_H
@@ -0,0 +1,88 @@
+#ifndef EEE4120F_YODA_YODA_TAR_H
+#define EEE4120F_YODA_YODA_TAR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "yoda.h"
+
+// Single-pass hashing of a tar archive. The headers are parsed as the stream goes by, each member's
+// data is hashed where it lies in the caller's buffer, and the whole archive is hashed alongside, so
+// a tarball is validated without being extracted. Understands ustar, GNU long names and pax path and
+// size records.
+namespace yoda {
+
+struct TarMember {
+    std::string name;
+    char type;        // Typeflag: '0' regular file, '2' symlink, '5' directory, ...
+    uint64_t size;    // Bytes of data in the archive
+    uint64_t offset;  // Offset of the data in the archive
+    Digest digest;    // Of the data, for regular files only
+};
+
+// Push parser: the archive can be fed in pieces of any size
+class TarHasher {
+public:
+    explicit TarHasher(Algorithm alg);
+    ~TarHasher();
+
+    void update(const uint8_t* data, size_t length);
+
+    // The source failed before its end (a read error); finish() then fails with the message
+    void streamFailed(const std::string& message);
+
+    // End of the stream. False if the archive was truncated, a header was malformed or the stream
+    // failed, see error().
+    bool finish();
+
+    const std::vector<TarMember>& members() const { return done; }
+    const Digest& archiveDigest() const { return archive; }  // Of every byte fed, valid after finish()
+    uint64_t archiveBytes() const { return fed; }
+    const std::string& error() const { return problem; }
+
+private:
+    enum class State { Header, Data, Padding, End, Failed };
+
+    void parse(const uint8_t* data, size_t length);
+    void header();
+    void endMember();
+    void fail(const std::string& message);
+
+    Algorithm alg;
+    State state;
+    uint64_t fed;
+    uint64_t parsed;  // Bytes consumed by the parser, which stops at the end-of-archive blocks
+    std::unique_ptr<Hasher> whole;
+    Digest archive;
+    std::string problem;
+
+    uint8_t block[512];  // Header being collected
+    size_t blockFilled;
+    int zeroBlocks;      // Two in a row end the archive
+
+    uint64_t remaining;  // Of the current member's data, then of its padding
+    TarMember member;
+    std::unique_ptr<Hasher> memberHasher;  // Regular files only
+    std::string extension;                 // Data of a GNU long name or pax header, for the next member
+    char extensionType;
+    std::string nextName;                  // Overrides for the next member from those headers
+    uint64_t nextSize;
+    bool hasNextSize;
+
+    std::vector<TarMember> done;
+};
+
+struct TarStats {
+    uint64_t bytes = 0;
+    uint64_t members = 0;
+    double seconds = 0;
+    bool ok = true;  // False if fd could not be read to its end, the archive then fails too
+};
+
+// Read fd to the end through the hasher. The next window is read while the current one is hashed.
+TarStats hashTarStream(int fd, TarHasher& tar);
+
+}
+
+#endif //EEE4120F_YODA_YODA_TAR_H
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "md5_simd.h"
+#include "md5_short.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define YODA_X86_SIMD 1
+#endif
+
+#ifdef YODA_X86_SIMD
+
+// Vectors of 32-bit words; the width decides the instruction set in the functions compiled for it
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+typedef uint32_t v8u32 __attribute__((vector_size(32)));
+
+// Where block j of a message comes from: the message itself for whole blocks, then the padded tail
+struct LaneInput {
+    const uint8_t* data;
+    size_t wholeBlocks;
+    size_t blocks;
+    uint8_t tail[128];
+};
+
+static void prepareLane(LaneInput& lane, const uint8_t* data, size_t length) {
+    lane.data = data;
+    lane.wholeBlocks = length / 64;
+    lane.blocks = (length + 8) / 64 + 1;
+
+    // Append the '1' bit, zero-pad to 56 bytes modulo 64 and append the 64-bit length in bits
+    size_t rest = length % 64;
+    memset(lane.tail, 0, sizeof(lane.tail));
+    if (rest > 0) memcpy(lane.tail, data + lane.wholeBlocks * 64, rest);
+    lane.tail[rest] = 0x80;
+
+    uint64_t bitLen = (uint64_t) length * 8;
+    size_t end = (lane.blocks - lane.wholeBlocks) * 64;
+    for (int i = 0; i < 8; ++i) {
+        lane.tail[end - 8 + i] = (uint8_t) (bitLen >> (i * 8));
+    }
+}
+
+// The 64 rounds on one block per lane, the round tables shared with the scalar code in md5_short.h
+template<typename V>
+static inline __attribute__((always_inline)) void md5Rounds(V& AA, V& BB, V& CC, V& DD, const V M[16]) {
+#pragma GCC unroll 64
+    for (int i = 0; i < 64; ++i) {
+        V f;
+        if (i < 16) f = (BB & CC) | (~BB & DD);
+        else if (i < 32) f = (BB & DD) | (CC & ~DD);
+        else if (i < 48) f = BB ^ CC ^ DD;
+        else f = CC ^ (BB | ~DD);
+
+        f = f + AA + md5K[i] + M[md5G[i]];
+        AA = DD;
+        DD = CC;
+        CC = BB;
+        BB = BB + ((f << md5S[i]) | (f >> (32 - md5S[i])));
+    }
+}
+
+// Hash N messages at once, lane l of every vector belonging to message l. Lanes whose message has
+// fewer blocks than the longest one keep their chaining values once they run out of blocks.
+template<typename V, int N>
+static inline __attribute__((always_inline)) void md5Lanes(const uint8_t* const* messages, const size_t* lengths,
+                                                            uint8_t* digests) {
+    LaneInput lanes[N];
+    size_t maxBlocks = 0;
+    for (int l = 0; l < N; ++l) {
+        prepareLane(lanes[l], messages[l], lengths[l]);
+        maxBlocks = std::max(maxBlocks, lanes[l].blocks);
+    }
+
+    V a = V{} + 0x67452301u;
+    V b = V{} + 0xefcdab89u;
+    V c = V{} + 0x98badcfeu;
+    V d = V{} + 0x10325476u;
+
+    for (size_t j = 0; j < maxBlocks; ++j) {
+        // Transpose: word w of every lane's block j into M[w]
+        alignas(32) uint32_t words[16][N];
+        alignas(32) uint32_t active[N];
+        for (int l = 0; l < N; ++l) {
+            const LaneInput& lane = lanes[l];
+            const uint8_t* block = (j < lane.wholeBlocks) ? lane.data + j * 64
+                                 : (j < lane.blocks) ? lane.tail + (j - lane.wholeBlocks) * 64
+                                 : lane.tail;
+            for (int w = 0; w < 16; ++w) {
+                memcpy(&words[w][l], block + w * 4, 4);  // x86 is little-endian like MD5
+            }
+            active[l] = (j < lane.blocks) ? 0xffffffffu : 0;
+        }
+
+        V M[16];
+        for (int w = 0; w < 16; ++w) memcpy(&M[w], words[w], sizeof(V));
+        V mask;
+        memcpy(&mask, active, sizeof(V));
+
+        V AA = a, BB = b, CC = c, DD = d;
+        md5Rounds(AA, BB, CC, DD, M);
+
+        // Add this block's hash to the result so far, in the lanes that still had a block
+        a = ((a + AA) & mask) | (a & ~mask);
+        b = ((b + BB) & mask) | (b & ~mask);
+        c = ((c + CC) & mask) | (c & ~mask);
+        d = ((d + DD) & mask) | (d & ~mask);
+    }
+
+    for (int l = 0; l < N; ++l) {
+        uint32_t state[4] = {a[l], b[l], c[l], d[l]};
+        memcpy(digests + 16 * l, state, 16);
+    }
+}
+
+// N messages of the same length, short enough to pad to a single block: no per-lane tail, no mask,
+// and only the first W words (message bytes and the 0x80 byte) are loaded. The words between them
+// and the length are zero at compile time and drop out of the rounds.
+template<typename V, int N, int W>
+static inline __attribute__((always_inline)) void md5LanesShort(const uint8_t* const* messages, size_t length,
+                                                                 uint8_t* digests) {
+    alignas(32) uint32_t words[W > 0 ? W : 1][N];
+    for (int l = 0; l < N; ++l) {
+        uint8_t block[W * 4 > 0 ? W * 4 : 1] = {0};
+        memcpy(block, messages[l], length);
+        block[length] = 0x80;
+        for (int w = 0; w < W; ++w) {
+            memcpy(&words[w][l], block + w * 4, 4);  // x86 is little-endian like MD5
+        }
+    }
+
+    V M[16];
+#pragma GCC unroll 16
+    for (int w = 0; w < 16; ++w) {
+        if (w < W) memcpy(&M[w], words[w], sizeof(V));
+        else M[w] = V{};
+    }
+    M[14] = V{} + (uint32_t) (length * 8);
+
+    V a = V{} + md5IV[0], b = V{} + md5IV[1], c = V{} + md5IV[2], d = V{} + md5IV[3];
+    md5Rounds(a, b, c, d, M);
+    a += md5IV[0];
+    b += md5IV[1];
+    c += md5IV[2];
+    d += md5IV[3];
+
+    for (int l = 0; l < N; ++l) {
+        uint32_t state[4] = {a[l], b[l], c[l], d[l]};
+        memcpy(digests + 16 * l, state, 16);
+    }
+}
+
+typedef void (*ShortLanesFn)(const uint8_t* const*, size_t, uint8_t*);
+
+template<int W>
+__attribute__((target("avx2"))) static void md5LanesShortAVX2(const uint8_t* const* messages, size_t length,
+                                                             uint8_t* digests) {
+    md5LanesShort<v8u32, 8, W>(messages, length, digests);
+}
+
+template<int W>
+__attribute__((target("sse2"))) static void md5LanesShortSSE2(const uint8_t* const* messages, size_t length,
+                                                             uint8_t* digests) {
+    md5LanesShort<v4u32, 4, W>(messages, length, digests);
+}
+
+// Indexed by W = length / 4 + 1, for lengths up to 55
+template<size_t... W>
+static constexpr std::array<ShortLanesFn, sizeof...(W)> shortLanesAVX2(std::index_sequence<W...>) {
+    return {md5LanesShortAVX2<(int) W + 1>...};
+}
+
+template<size_t... W>
+static constexpr std::array<ShortLanesFn, sizeof...(W)> shortLanesSSE2(std::index_sequence<W...>) {
+    return {md5LanesShortSSE2<(int) W + 1>...};
+}
+
+static constexpr std::array<ShortLanesFn, 14> shortAVX2 = shortLanesAVX2(std::make_index_sequence<14>());
+static constexpr std::array<ShortLanesFn, 14> shortSSE2 = shortLanesSSE2(std::make_index_sequence<14>());
+
+__attribute__((target("avx2"))) static void md5LanesAVX2(const uint8_t* const* messages, const size_t* lengths,
+                                                        uint8_t* digests) {
+    md5Lanes<v8u32, 8>(messages, lengths, digests);
+}
+
+__attribute__((target("sse2"))) static void md5LanesSSE2(const uint8_t* const* messages, const size_t* lengths,
+                                                        uint8_t* digests) {
+    md5Lanes<v4u32, 4>(messages, lengths, digests);
+}
+
+int md5SimdLanes() {
+    static const int lanes = __builtin_cpu_supports("avx2") ? 8 : __builtin_cpu_supports("sse2") ? 4 : 0;
+    return lanes;
+}
+
+void md5BatchSIMD(const uint8_t* const* messages, const size_t* lengths, size_t count, uint8_t* digests) {
+    const int lanes = md5SimdLanes();
+    static const uint8_t empty[1] = {0};
+
+    for (size_t first = 0; first < count; first += lanes) {
+        size_t group = std::min(count - first, (size_t) lanes);
+
+        // A short last group is filled up with empty messages whose digests are dropped
+        const uint8_t* groupMessages[8];
+        size_t groupLengths[8] = {0};
+        uint8_t groupDigests[8 * 16];
+        for (int l = 0; l < lanes; ++l) {
+            groupMessages[l] = (l < (int) group) ? messages[first + l] : empty;
+            groupLengths[l] = (l < (int) group) ? lengths[first + l] : 0;
+        }
+
+        // A full group of equal single-block lengths (fixed-size keys) takes the specialised path
+        bool uniform = group == (size_t) lanes && groupLengths[0] <= md5ShortLaneMax &&
+                       std::all_of(groupLengths, groupLengths + lanes,
+                                   [&](size_t length) { return length == groupLengths[0]; });
+        if (uniform) {
+            const ShortLanesFn* table = (lanes == 8) ? shortAVX2.data() : shortSSE2.data();
+            table[groupLengths[0] / 4](groupMessages, groupLengths[0], groupDigests);
+        } else if (lanes == 8) {
+            md5LanesAVX2(groupMessages, groupLengths, groupDigests);
+        } else {
+            md5LanesSSE2(groupMessages, groupLengths, groupDigests);
+        }
+
+        memcpy(digests + 16 * first, groupDigests, 16 * group);
+    }
+}
+
+#else
+
+int md5SimdLanes() {
+    return 0;
+}
+
+void md5BatchSIMD(const uint8_t* const*, const size_t*, size_t, uint8_t*) {
+}
+
+#endif
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include "md5.h"
+#include "md5_short.h"
+#include "md5_simd.h"
+#include "yoda_engines.h"
+#include "md6.h"
+#include "md6_batch.h"
+#include "md6_tree.h"
+
+#ifdef YODA_WITH_OPENCL
+#include "yoda_opencl.h"
+#endif
+
+namespace yoda {
+
+static std::atomic<int> forcedEngine{(int) Engine::Auto};
+static thread_local Engine last = Engine::Scalar;
+
+struct Hasher::State {
+    MD5Context md5;
+    md6_state md6;
+    uint64_t bytes;
+};
+
+static Features detectFeatures() {
+    Features f;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    f.sse2 = __builtin_cpu_supports("sse2");
+    f.avx2 = __builtin_cpu_supports("avx2");
+#else
+    f.sse2 = false;
+    f.avx2 = false;
+#endif
+    f.cores = std::thread::hardware_concurrency();
+    if (f.cores == 0) f.cores = 1;
+#ifdef YODA_WITH_OPENCL
+    f.opencl = yodaOpenCLProbe(f.device);
+#else
+    f.opencl = false;
+#endif
+    return f;
+}
+
+const Features& features() {
+    static const Features f = detectFeatures();
+    return f;
+}
+
+// MD6 parameters shared by all calls: d = md6DigestBits, no key, default L and r
+static const md6_state& md6Params() {
+    static const md6_state* params = [] {
+        auto* st = new md6_state;
+        md6_init(st, md6DigestBits);
+        return st;
+    }();
+    return *params;
+}
+
+size_t digestLength(Algorithm alg) {
+    return (alg == Algorithm::MD5) ? 16 : md6DigestBits / 8;
+}
+
+static bool canRun(Engine engine, Algorithm alg) {
+    switch (engine) {
+        case Engine::Scalar: return true;
+        case Engine::SIMD: return alg == Algorithm::MD5 && md5SimdLanes() > 0;
+        case Engine::Threaded: return alg == Algorithm::MD6;
+        case Engine::OpenCL:
+        case Engine::Hybrid: return alg == Algorithm::MD6 && features().opencl;
+        default: return false;
+    }
+}
+
+Engine selectEngine(Algorithm alg, uint64_t length, size_t count) {
+    Engine forced = (Engine) forcedEngine.load();
+    if (forced != Engine::Auto && canRun(forced, alg)) return forced;
+
+    const Features& f = features();
+    const Profile p = profile();
+
+    if (alg == Algorithm::MD5) {
+        // A single MD5 message is strictly sequential; only batches can fill the vector lanes
+        return (md5SimdLanes() > 0 && count > 1 && count >= p.md5SimdMinBatch) ? Engine::SIMD : Engine::Scalar;
+    }
+
+    // For batches, length is the longest message
+    bool threaded = f.cores > 1 && (length >= p.md6ThreadedMinBytes || (count > 1 && count >= p.md6ThreadedMinBatch));
+    if (f.opencl && length >= p.md6OpenCLMinBytes) return (count > 1) ? Engine::Hybrid : Engine::OpenCL;
+    return threaded ? Engine::Threaded : Engine::Scalar;
+}
+
+static void md5Scalar(const uint8_t* data, size_t length, uint8_t* digest) {
+    if (length <= 119) {
+        std::array<uint8_t, 16> result = md5Short(data, length);
+        memcpy(digest, result.data(), result.size());
+        return;
+    }
+
+    MD5Context ctx;
+    md5Init(ctx);
+    md5Update(ctx, data, length);
+    std::array<uint8_t, 16> result = md5Final(ctx);
+    memcpy(digest, result.data(), result.size());
+}
+
+static void md6Scalar(const uint8_t* data, size_t length, uint8_t* digest) {
+    std::unique_ptr<md6_state> st(new md6_state(md6Params()));
+    md6_update(st.get(), data, (uint64_t) length * 8);
+    md6_final(st.get(), digest);
+    metricsCompressions(st->compression_calls);
+}
+
+// One level pass over all cores, without the node index md6_tree_hash keeps for re-hashing. False if
+// md6_tree failed, the digest is then not written.
+static bool md6Threaded(const uint8_t* data, size_t length, uint8_t* digest) {
+    const md6_state& params = md6Params();
+    std::unique_ptr<md6_tree> tree(new md6_tree);
+    if (md6_tree_init(tree.get(), params.d, nullptr, 0, params.L, params.r) != MD6_SUCCESS ||
+        md6_tree_digest(tree.get(), data, length, digest) != MD6_SUCCESS)
+        return false;
+    metricsCompressions(md6TreeCompressions(length));
+    return true;
+}
+
+// Hash one message on the given engine
+Engine hashOne(Algorithm alg, Engine engine, const uint8_t* data, size_t length, uint8_t* digest) {
+    if (alg == Algorithm::MD5) {
+        if (engine == Engine::SIMD) {
+            md5BatchSIMD(&data, &length, 1, digest);
+            return Engine::SIMD;
+        }
+        md5Scalar(data, length, digest);
+        return Engine::Scalar;
+    }
+
+#ifdef YODA_WITH_OPENCL
+    if (engine == Engine::OpenCL || engine == Engine::Hybrid) {
+        if (yodaOpenCLHashMD6(data, length, &md6Params(), digest)) {
+            metricsCompressions(md6TreeCompressions(length));
+            return Engine::OpenCL;
+        }
+        engine = Engine::Threaded;  // The device failed, stay off the slow path
+    }
+#endif
+
+    // A failed tree falls back to the sequential mode, so lastEngine() shows that it did
+    if ((engine == Engine::Threaded || engine == Engine::Hybrid) && md6Threaded(data, length, digest)) {
+        return Engine::Threaded;
+    }
+    md6Scalar(data, length, digest);
+    return Engine::Scalar;
+}
+
+Digest hash(Algorithm alg, const uint8_t* data, size_t length) {
+    MetricsToken token = metricsStart(length);
+    Digest digest(digestLength(alg));
+    last = hashOne(alg, selectEngine(alg, length, 1), data, length, digest.data());
+    metricsRecord(token, alg, last, 1, length);
+    return digest;
+}
+
+Digest hash(Algorithm alg, const std::string& data) {
+    return hash(alg, (const uint8_t*) data.data(), data.size());
+}
+
+// MD6 batch on the CPU: one worker per core with md6_batch, or all cores on each message in turn when
+// the messages are large enough for the threaded tree
+static void md6BatchCPU(const uint8_t* const* messages, const size_t* lengths, const std::vector<size_t>& indices,
+                        uint8_t* digests) {
+    const size_t digestLen = md6DigestBits / 8;
+    uint64_t bytes = 0;
+    for (size_t i : indices) bytes += lengths[i];
+
+    if (!indices.empty() && bytes / indices.size() >= profile().md6ThreadedMinBytes) {
+        for (size_t i : indices) {
+            if (!md6Threaded(messages[i], lengths[i], digests + i * digestLen))
+                md6Scalar(messages[i], lengths[i], digests + i * digestLen);
+        }
+        return;
+    }
+
+    std::vector<const uint8_t*> batchMessages;
+    std::vector<uint64_t> batchLengths;
+    for (size_t i : indices) {
+        batchMessages.push_back(messages[i]);
+        batchLengths.push_back(lengths[i]);
+    }
+
+    std::vector<uint8_t> batchDigests(indices.size() * digestLen);
+    md6_batch batch;
+    md6_batch_init(&batch, 0);
+    md6_batch_hash(&batch, &md6Params(), batchMessages.data(), batchLengths.data(), indices.size(),
+                   batchDigests.data());
+    md6_batch_free(&batch);
+
+    uint64_t compressions = 0;
+    for (size_t j = 0; j < indices.size(); j++) {
+        memcpy(digests + indices[j] * digestLen, &batchDigests[j * digestLen], digestLen);
+        compressions += md6TreeCompressions(batchLengths[j]);
+    }
+    metricsCompressions(compressions);
+}
+
+#ifdef YODA_WITH_OPENCL
+// Split an MD6 batch between the device and the CPU in proportion to their measured throughput. The
+// device takes the largest messages (the ones that amortise its launch and transfer cost) until it
+// holds its share of the bytes; both sides then run at the same time.
+static Engine md6BatchHybrid(const uint8_t* const* messages, const size_t* lengths, size_t count, uint8_t* digests) {
+    const Profile p = profile();
+    const size_t digestLen = md6DigestBits / 8;
+
+    double cpuRate = p.md6CpuBytesPerSecond;
+    double deviceRate = p.md6OpenCLBytesPerSecond;
+    double share = (cpuRate + deviceRate > 0) ? deviceRate / (cpuRate + deviceRate) : 0.5;
+
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return lengths[a] > lengths[b]; });
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) total += lengths[i];
+
+    std::vector<size_t> device, cpu;
+    uint64_t deviceBytes = 0;
+    for (size_t i : order) {
+        if (lengths[i] >= p.md6OpenCLMinBytes && deviceBytes < share * total) {
+            device.push_back(i);
+            deviceBytes += lengths[i];
+        } else {
+            cpu.push_back(i);
+        }
+    }
+
+    std::vector<size_t> failed;
+    std::thread deviceThread([&] {
+        for (size_t i : device) {
+            if (yodaOpenCLHashMD6(messages[i], lengths[i], &md6Params(), digests + i * digestLen)) {
+                metricsCompressions(md6TreeCompressions(lengths[i]));
+            } else {
+                failed.push_back(i);
+            }
+        }
+    });
+    md6BatchCPU(messages, lengths, cpu, digests);
+    deviceThread.join();
+
+    // Whatever the device could not do is finished on the CPU
+    md6BatchCPU(messages, lengths, failed, digests);
+
+    if (device.size() == failed.size()) return Engine::Threaded;
+    return cpu.empty() && failed.empty() ? Engine::OpenCL : Engine::Hybrid;
+}
+#endif
+
+Engine hashMany(Algorithm alg, Engine engine, const uint8_t* const* messages, const size_t* lengths, size_t count,
+                uint8_t* digests) {
+    if (alg == Algorithm::MD5 && engine == Engine::SIMD) {
+        md5BatchSIMD(messages, lengths, count, digests);
+        return Engine::SIMD;
+    }
+
+#ifdef YODA_WITH_OPENCL
+    if (alg == Algorithm::MD6 && engine == Engine::Hybrid) return md6BatchHybrid(messages, lengths, count, digests);
+#endif
+
+    if (alg == Algorithm::MD6 && (engine == Engine::Threaded || engine == Engine::Hybrid)) {
+        std::vector<size_t> indices(count);
+        std::iota(indices.begin(), indices.end(), 0);
+        md6BatchCPU(messages, lengths, indices, digests);
+        return Engine::Threaded;
+    }
+
+    size_t digestLen = digestLength(alg);
+    for (size_t i = 0; i < count; i++) {
+        engine = hashOne(alg, engine, messages[i], lengths[i], digests + i * digestLen);
+    }
+    return engine;
+}
+
+std::vector<Digest> hashBatch(Algorithm alg, const uint8_t* const* messages, const size_t* lengths, size_t count) {
+    size_t digestLen = digestLength(alg);
+    std::vector<uint8_t> digests(count * digestLen);
+
+    uint64_t longest = 0, bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] > longest) longest = lengths[i];
+        bytes += lengths[i];
+    }
+
+    MetricsToken token = metricsStart(bytes);
+    last = hashMany(alg, selectEngine(alg, longest, count), messages, lengths, count, digests.data());
+    metricsRecord(token, alg, last, count, bytes);
+
+    std::vector<Digest> result(count);
+    for (size_t i = 0; i < count; i++) {
+        result[i].assign(digests.begin() + i * digestLen, digests.begin() + (i + 1) * digestLen);
+    }
+    return result;
+}
+
+std::vector<Digest> hashBatch(Algorithm alg, const std::vector<std::string>& messages) {
+    std::vector<const uint8_t*> pointers(messages.size());
+    std::vector<size_t> lengths(messages.size());
+    for (size_t i = 0; i < messages.size(); i++) {
+        pointers[i] = (const uint8_t*) messages[i].data();
+        lengths[i] = messages[i].size();
+    }
+    return hashBatch(alg, pointers.data(), lengths.data(), messages.size());
+}
+
+// Streaming hashes are sequential by nature and always run on the scalar engine
+Hasher::Hasher(Algorithm alg) : alg(alg), state(new State) {
+    if (alg == Algorithm::MD5) md5Init(state->md5);
+    else state->md6 = md6Params();
+    state->bytes = 0;
+}
+
+Hasher::~Hasher() = default;
+
+void Hasher::update(const uint8_t* data, size_t length) {
+    if (alg == Algorithm::MD5) md5Update(state->md5, data, length);
+    else md6_update(&state->md6, data, (uint64_t) length * 8);
+    state->bytes += length;
+}
+
+void Hasher::update(const std::string& data) {
+    update((const uint8_t*) data.data(), data.size());
+}
+
+Digest Hasher::final() {
+    MetricsToken token = metricsStart(state->bytes);
+    Digest digest(digestLength(alg));
+    if (alg == Algorithm::MD5) {
+        std::array<uint8_t, 16> result = md5Final(state->md5);
+        memcpy(digest.data(), result.data(), result.size());
+    } else {
+        md6_final(&state->md6, digest.data());
+        metricsCompressions(state->md6.compression_calls);
+    }
+    last = Engine::Scalar;
+    metricsRecord(token, alg, last, 1, state->bytes);
+    return digest;
+}
+
+Engine lastEngine() {
+    return last;
+}
+
+const char* engineName(Engine engine) {
+    switch (engine) {
+        case Engine::Auto: return "auto";
+        case Engine::Scalar: return "scalar";
+        case Engine::SIMD: return "simd";
+        case Engine::Threaded: return "threaded";
+        case Engine::OpenCL: return "opencl";
+        case Engine::Hybrid: return "hybrid";
+    }
+    return "unknown";
+}
+
+std::string toHex(const Digest& digest) {
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string hex;
+    for (uint8_t byte : digest) {
+        hex += hexDigits[byte >> 4];
+        hex += hexDigits[byte & 0x0f];
+    }
+    return hex;
+}
+
+void setEngine(Engine engine) {
+    forcedEngine = (int) engine;
+}
+
+}
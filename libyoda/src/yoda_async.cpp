@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "yoda_async.h"
+
+namespace yoda {
+
+// Coroutine behind EventLoop::spawn: runs the task to completion and reports back to the loop
+struct SpawnedTask {
+    struct promise_type {
+        SpawnedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    static SpawnedTask start(EventLoop* loop, Task<void> task) {
+        try {
+            co_await task;
+        } catch (...) {
+            if (!loop->firstError) loop->firstError = std::current_exception();
+        }
+        loop->spawned--;
+    }
+};
+
+EventLoop::EventLoop() : spawned(0) {
+    if (pipe(pipeFds) != 0) throw std::system_error(errno, std::generic_category(), "pipe");
+    for (int fd : pipeFds) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+}
+
+EventLoop::~EventLoop() {
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+}
+
+void EventLoop::post(std::coroutine_handle<> handle) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wasEmpty = ready.empty();
+        ready.push_back(handle);
+    }
+
+    // One byte per batch of posts: the loop takes the whole queue when it wakes up
+    if (wasEmpty) {
+        char byte = 0;
+        while (write(pipeFds[1], &byte, 1) < 0 && errno == EINTR) {}
+    }
+}
+
+void EventLoop::runReady() {
+    char bytes[64];
+    while (read(pipeFds[0], bytes, sizeof(bytes)) > 0) {}
+
+    std::deque<std::coroutine_handle<>> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(ready);
+    }
+    for (std::coroutine_handle<> handle : batch) handle.resume();
+}
+
+void EventLoop::run() {
+    while (spawned > 0) {
+        pollfd p{pipeFds[0], POLLIN, 0};
+        if (poll(&p, 1, -1) < 0 && errno != EINTR) break;
+        runReady();
+    }
+
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void EventLoop::spawn(Task<void> task) {
+    spawned++;
+    SpawnedTask::start(this, std::move(task));
+}
+
+WorkerPool::WorkerPool(unsigned int threads) : stopping(false) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back([this] {
+            for (;;) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                    if (jobs.empty()) return;
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+                job();
+            }
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+// co_await SliceJobs(...): job(0) .. job(count - 1) run in parallel on the pool, and the last one to
+// finish resumes the awaiting coroutine
+class SliceJobs {
+public:
+    SliceJobs(EventLoop& loop, WorkerPool& pool, size_t count, std::function<void(size_t)> job)
+            : loop(loop), pool(pool), count(count), job(std::move(job)), remaining(count) {}
+
+    bool await_ready() const noexcept { return count == 0; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        for (size_t i = 0; i < count; i++) {
+            pool.submit([this, handle, i] {
+                try {
+                    job(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+                if (remaining.fetch_sub(1) == 1) loop.post(handle);
+            });
+        }
+    }
+    void await_resume() {
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    EventLoop& loop;
+    WorkerPool& pool;
+    size_t count;
+    std::function<void(size_t)> job;
+    std::atomic<size_t> remaining;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+Task<Digest> hashFileAsync(EventLoop& loop, WorkerPool& pool, Algorithm alg, std::string path, CancelToken token) {
+    const size_t maxChunk = 1 << 20;
+
+    // Opening can block too (network file systems), so it runs on the pool like the reads
+    struct Opened {
+        int fd;
+        size_t chunk;
+    };
+    Opened file = co_await offload(loop, pool, [&path, maxChunk] {
+        Opened opened{open(path.c_str(), O_RDONLY | O_CLOEXEC), maxChunk};
+        struct stat st;
+        if (opened.fd >= 0 && fstat(opened.fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            opened.chunk = std::clamp((size_t) st.st_size + 1, (size_t) 4096, maxChunk);
+        }
+        return opened;
+    });
+    if (file.fd < 0) co_return Digest();
+
+    // Thousands of files may be in flight: the buffer is sized to the file and left uninitialised
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[file.chunk]);
+    Hasher hasher(alg);
+    bool failed = false;
+
+    // One job per chunk, so that the hasher belongs to one thread at a time. Cancellation is seen
+    // between chunks, including by reads that were already queued.
+    while (!failed) {
+        ssize_t n = co_await offload(loop, pool, [&] {
+            if (token.cancelled()) return (ssize_t) -1;
+            ssize_t got;
+            do {
+                got = read(file.fd, buffer.get(), file.chunk);
+            } while (got < 0 && errno == EINTR);
+            if (got > 0) hasher.update(buffer.get(), got);
+            return got;
+        });
+        if (n < 0) failed = true;
+        if (n <= 0) break;
+    }
+    close(file.fd);
+
+    co_return failed ? Digest() : hasher.final();
+}
+
+Task<std::vector<Digest>> hashBatchAsync(EventLoop& loop, WorkerPool& pool, Algorithm alg,
+                                         std::vector<std::string> messages, CancelToken token) {
+    // Slices large enough for the multi-buffer and threaded batch engines to pay off
+    const size_t sliceSize = 256;
+    size_t slices = (messages.size() + sliceSize - 1) / sliceSize;
+    std::vector<Digest> digests(messages.size());
+
+    co_await SliceJobs(loop, pool, slices, [&](size_t slice) {
+        if (token.cancelled()) return;
+
+        size_t first = slice * sliceSize;
+        size_t count = std::min(sliceSize, messages.size() - first);
+        std::vector<const uint8_t*> data(count);
+        std::vector<size_t> lengths(count);
+        for (size_t i = 0; i < count; i++) {
+            data[i] = (const uint8_t*) messages[first + i].data();
+            lengths[i] = messages[first + i].size();
+        }
+
+        std::vector<Digest> sliceDigests = hashBatch(alg, data.data(), lengths.data(), count);
+        std::move(sliceDigests.begin(), sliceDigests.end(), digests.begin() + first);
+    });
+
+    if (token.cancelled()) co_return std::vector<Digest>();
+    co_return digests;
+}
+
+}
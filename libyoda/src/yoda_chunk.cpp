@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <unistd.h>
+#include "yoda_chunk.h"
+#include "yoda_engines.h"
+
+namespace yoda {
+
+// Random 64-bit value per byte value, the same in every build so that chunk boundaries are too
+static const uint64_t* gearTable() {
+    static uint64_t table[256];
+    static bool filled = [] {
+        uint64_t x = 0x59dace6fa1f3ce2bULL;
+        for (uint64_t& entry : table) {
+            // splitmix64
+            x += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            entry = z ^ (z >> 31);
+        }
+        return true;
+    }();
+    (void) filled;
+    return table;
+}
+
+Chunker::Chunker(const ChunkParams& params) : p(params) {
+    int bits = 63 - __builtin_clzll(p.averageSize);
+
+    // The Gear hash shifts left, so its top bits depend on the most recent 64 bytes
+    maskSmall = ~0ULL << (64 - (bits + 2));
+    maskLarge = ~0ULL << (64 - (bits - 2));
+    gearTable();
+}
+
+size_t Chunker::cut(const uint8_t* data, size_t length) const {
+    size_t n = std::min(length, p.maxSize);
+    if (n <= p.minSize) return n;
+
+    const uint64_t* gear = gearTable();
+    size_t normal = std::min(n, p.averageSize);
+    uint64_t fp = 0;
+    size_t i = p.minSize;
+
+    for (; i < normal; i++) {
+        fp = (fp << 1) + gear[data[i]];
+        if (!(fp & maskSmall)) return i + 1;
+    }
+    for (; i < n; i++) {
+        fp = (fp << 1) + gear[data[i]];
+        if (!(fp & maskLarge)) return i + 1;
+    }
+    return n;
+}
+
+ChunkIndex::ChunkIndex() : file(nullptr), digestLen(0) {
+}
+
+ChunkIndex::~ChunkIndex() {
+    close();
+}
+
+// File layout: "YODACDX1", the algorithm byte, then one record per chunk of a 4-byte length and the digest
+bool ChunkIndex::open(const std::string& path, Algorithm alg) {
+    close();
+    digestLen = digestLength(alg);
+    const char magic[8] = {'Y', 'O', 'D', 'A', 'C', 'D', 'X', '1'};
+    const uint8_t algByte = (alg == Algorithm::MD5) ? 0 : 1;
+
+    file = fopen(path.c_str(), "a+b");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+
+    if (ftell(file) == 0) {
+        fwrite(magic, 1, sizeof(magic), file);
+        fwrite(&algByte, 1, 1, file);
+        return fflush(file) == 0;
+    }
+
+    char header[9];
+    rewind(file);
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, magic, sizeof(magic)) != 0 ||
+        (uint8_t) header[8] != algByte) {
+        close();
+        return false;
+    }
+
+    std::vector<uint8_t> record(4 + digestLen);
+    uint64_t records = 0;
+    while (fread(record.data(), 1, record.size(), file) == record.size()) {
+        seen.emplace((const char*) record.data() + 4, digestLen);
+        records++;
+    }
+
+    // "a+b" appends at the end whatever the position, so a torn last record (a write cut short) is cut
+    // off here, or every record after it would be read out of step
+    off_t whole = (off_t) (sizeof(header) + records * record.size());
+    if (fseek(file, 0, SEEK_END) != 0 || (ftell(file) != whole && ftruncate(fileno(file), whole) != 0)) {
+        close();
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    return true;
+}
+
+void ChunkIndex::close() {
+    if (file != nullptr) fclose(file);
+    file = nullptr;
+    seen.clear();
+}
+
+bool ChunkIndex::insert(const uint8_t* digest, uint32_t length) {
+    if (!seen.emplace((const char*) digest, digestLen).second) return false;
+    if (file != nullptr) {
+        fwrite(&length, sizeof(length), 1, file);
+        fwrite(digest, 1, digestLen, file);
+    }
+    return true;
+}
+
+// One read window and the chunks found in it
+struct Window {
+    std::vector<uint8_t> buffer;
+    size_t filled = 0;
+    std::vector<const uint8_t*> chunks;
+    std::vector<size_t> lengths;
+    std::vector<uint8_t> digests;
+};
+
+static void hashWindow(Algorithm alg, Window& w) {
+    const size_t digestLen = digestLength(alg);
+    std::vector<Digest> digests = hashBatch(alg, w.chunks.data(), w.lengths.data(), w.chunks.size());
+
+    w.digests.resize(w.chunks.size() * digestLen);
+    for (size_t i = 0; i < digests.size(); i++) memcpy(&w.digests[i * digestLen], digests[i].data(), digestLen);
+}
+
+DedupStats dedupStream(int fd, Algorithm alg, ChunkIndex& index, const ChunkParams& params) {
+    const size_t windowSize = 16 << 20;
+    const size_t digestLen = digestLength(alg);
+    Chunker chunker(params);
+    DedupStats stats;
+    auto start = std::chrono::steady_clock::now();
+
+    Window windows[2];
+    for (Window& w : windows) w.buffer.resize(windowSize + params.maxSize);
+
+    std::future<void> hashing;
+    Window* previous = nullptr;
+    const uint8_t* tail = nullptr;
+    size_t tailLength = 0;
+    bool end = false;
+
+    for (int k = 0; !end || previous != nullptr; k++) {
+        Window& w = windows[k % 2];
+        w.chunks.clear();
+        w.lengths.clear();
+
+        // The unchunked end of the last window moves to the front of this one, the rest is read
+        if (!end) {
+            memmove(w.buffer.data(), tail, tailLength);
+            w.filled = tailLength;
+            while (w.filled < w.buffer.size()) {
+                ssize_t n = read(fd, w.buffer.data() + w.filled, w.buffer.size() - w.filled);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    if (n < 0) stats.ok = false;
+                    end = true;
+                    break;
+                }
+                w.filled += n;
+            }
+
+            size_t offset = 0;
+            while (offset < w.filled && (end || w.filled - offset >= params.maxSize)) {
+                size_t length = chunker.cut(w.buffer.data() + offset, w.filled - offset);
+                w.chunks.push_back(w.buffer.data() + offset);
+                w.lengths.push_back(length);
+                offset += length;
+            }
+            tail = w.buffer.data() + offset;
+            tailLength = w.filled - offset;
+        }
+
+        // Index the chunks of the previous window, hashed while this one was read
+        if (previous != nullptr) {
+            hashing.get();
+            for (size_t i = 0; i < previous->chunks.size(); i++) {
+                stats.chunks++;
+                stats.bytes += previous->lengths[i];
+                if (index.insert(&previous->digests[i * digestLen], (uint32_t) previous->lengths[i])) {
+                    stats.uniqueChunks++;
+                    stats.uniqueBytes += previous->lengths[i];
+                }
+            }
+            previous = nullptr;
+        }
+
+        if (!w.chunks.empty()) {
+            hashing = std::async(std::launch::async, hashWindow, alg, std::ref(w));
+            previous = &w;
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+}
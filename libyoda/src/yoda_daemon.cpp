@@ -0,0 +1,78 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "yoda_daemon.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS: the daemon ignores SIGPIPE instead
+#endif
+
+namespace yoda {
+
+bool readFull(int fd, void* data, size_t length) {
+    auto* bytes = (uint8_t*) data;
+    while (length > 0) {
+        ssize_t n = read(fd, bytes, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool writeFull(int fd, const void* data, size_t length) {
+    auto* bytes = (const uint8_t*) data;
+    while (length > 0) {
+        ssize_t n = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        length -= n;
+    }
+    return true;
+}
+
+DaemonClient::DaemonClient() : fd(-1), engine(Engine::Scalar) {
+}
+
+DaemonClient::~DaemonClient() {
+    if (fd >= 0) close(fd);
+}
+
+bool DaemonClient::connect(const std::string& path) {
+    if (fd >= 0) close(fd);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    strcpy(addr.sun_path, path.c_str());
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    if (::connect(fd, (sockaddr*) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool DaemonClient::hash(Algorithm alg, const uint8_t* data, size_t length, Digest& digest) {
+    if (fd < 0 || length > maxRequestBytes) return false;
+
+    RequestHeader request{};
+    request.algorithm = (alg == Algorithm::MD5) ? 0 : 1;
+    request.length = (uint32_t) length;
+    if (!writeFull(fd, &request, sizeof(request)) || !writeFull(fd, data, length)) return false;
+
+    ResponseHeader response{};
+    if (!readFull(fd, &response, sizeof(response)) || response.status != 0) return false;
+    digest.resize(response.length);
+    engine = (Engine) response.engine;
+    return readFull(fd, digest.data(), digest.size());
+}
+
+}
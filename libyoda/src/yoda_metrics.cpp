@@ -0,0 +1,276 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include "yoda_engines.h"
+#include "yoda_metrics.h"
+
+namespace yoda {
+
+static std::atomic<bool> enabled{true};
+
+// Calls under 4 KiB are recorded 1 in this many, with this weight: a clock read costs about as much as
+// hashing 64 bytes, and even a plain counter update is a measurable share of such a call
+static const unsigned int shortSample = 256;
+
+int Histogram::bucketOf(uint64_t nanoseconds) {
+    if (nanoseconds < 16) return (int) nanoseconds;
+    int power = 63 - __builtin_clzll(nanoseconds);
+    if (power > 41) return buckets - 1;
+    int sub = (int) (nanoseconds >> (power - 4)) & 15;
+    return 16 + (power - 4) * 16 + sub;
+}
+
+uint64_t Histogram::lowerBound(int bucket) {
+    if (bucket < 16) return bucket;
+    int power = 4 + (bucket - 16) / 16;
+    return (uint64_t) (16 + (bucket - 16) % 16) << (power - 4);
+}
+
+uint64_t Histogram::count() const {
+    uint64_t total = 0;
+    for (uint64_t c : counts) total += c;
+    return total;
+}
+
+uint64_t Histogram::quantile(double q) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t) (q * (total - 1)), seen = 0;
+    for (int i = 0; i < buckets; i++) {
+        seen += counts[i];
+        if (seen > rank) {
+            uint64_t low = lowerBound(i);
+            uint64_t high = (i + 1 < buckets) ? lowerBound(i + 1) : low;
+            return low + (high - low) / 2;
+        }
+    }
+    return lowerBound(buckets - 1);
+}
+
+// The recording side. Only the owning thread writes its counters, so a relaxed load and store
+// is enough and compiles to a plain add; metrics() may read them at any time.
+struct AtomicEngineMetrics {
+    std::atomic<uint64_t> latency[Histogram::buckets];
+    std::atomic<uint64_t> calls, messages, bytes, nanoseconds;
+};
+
+struct ThreadMetrics {
+    AtomicEngineMetrics engines[2][6];
+    std::atomic<uint64_t> md6Compressions, openclBytesToDevice, openclBytesFromDevice;
+    unsigned int shortCalls;  // Owning thread only
+
+    ThreadMetrics() : shortCalls(0) { clear(); }
+
+    void clear() {
+        for (auto& alg : engines) {
+            for (AtomicEngineMetrics& e : alg) {
+                for (std::atomic<uint64_t>& c : e.latency) c.store(0, std::memory_order_relaxed);
+                e.calls = e.messages = e.bytes = e.nanoseconds = 0;
+            }
+        }
+        md6Compressions = openclBytesToDevice = openclBytesFromDevice = 0;
+    }
+
+    void addTo(Metrics& m) const {
+        for (int a = 0; a < 2; a++) {
+            for (int e = 0; e < 6; e++) {
+                const AtomicEngineMetrics& from = engines[a][e];
+                EngineMetrics& to = m.engines[a][e];
+                for (int i = 0; i < Histogram::buckets; i++) to.latency.counts[i] += from.latency[i].load(std::memory_order_relaxed);
+                to.calls += from.calls.load(std::memory_order_relaxed);
+                to.messages += from.messages.load(std::memory_order_relaxed);
+                to.bytes += from.bytes.load(std::memory_order_relaxed);
+                to.nanoseconds += from.nanoseconds.load(std::memory_order_relaxed);
+            }
+        }
+        m.md6Compressions += md6Compressions.load(std::memory_order_relaxed);
+        m.openclBytesToDevice += openclBytesToDevice.load(std::memory_order_relaxed);
+        m.openclBytesFromDevice += openclBytesFromDevice.load(std::memory_order_relaxed);
+    }
+};
+
+static inline void bump(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Counters of running threads, and the totals of threads that have exited
+static std::mutex registryMutex;
+static std::vector<ThreadMetrics*> live;
+static Metrics retired;
+
+struct Registration {
+    ThreadMetrics* metrics;
+
+    Registration() : metrics(new ThreadMetrics) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        live.push_back(metrics);
+    }
+
+    ~Registration() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        metrics->addTo(retired);
+        for (size_t i = 0; i < live.size(); i++) {
+            if (live[i] == metrics) {
+                live.erase(live.begin() + i);
+                break;
+            }
+        }
+        delete metrics;
+    }
+};
+
+// The registration needs a TLS guard on every access, the plain pointer does not
+static thread_local ThreadMetrics* cached = nullptr;
+
+__attribute__((noinline)) static ThreadMetrics& registerThread() {
+    static thread_local Registration registration;
+    cached = registration.metrics;
+    return *cached;
+}
+
+static inline ThreadMetrics& local() {
+    return cached != nullptr ? *cached : registerThread();
+}
+
+static inline uint64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+MetricsToken metricsStart(uint64_t bytes) {
+    if (!enabled.load(std::memory_order_relaxed)) return MetricsToken{nullptr, 0};
+    ThreadMetrics& t = local();
+    if (bytes < 4096 && ++t.shortCalls % shortSample != 0) return MetricsToken{nullptr, 0};  // Outside the sample
+    return MetricsToken{&t, nowNanoseconds()};
+}
+
+void metricsRecord(MetricsToken token, Algorithm alg, Engine engine, size_t messages, uint64_t bytes) {
+    if (token.thread == nullptr) return;
+
+    uint64_t elapsed = nowNanoseconds() - token.start;
+    uint64_t weight = (bytes < 4096) ? shortSample : 1;
+    AtomicEngineMetrics& e = token.thread->engines[alg == Algorithm::MD5 ? 0 : 1][(int) engine];
+    bump(e.calls, weight);
+    bump(e.messages, messages * weight);
+    bump(e.bytes, bytes * weight);
+    bump(e.latency[Histogram::bucketOf(elapsed)], weight);
+    bump(e.nanoseconds, elapsed * weight);
+}
+
+void metricsCompressions(uint64_t count) {
+    if (enabled.load(std::memory_order_relaxed)) bump(local().md6Compressions, count);
+}
+
+void metricsOpenCLTransfer(uint64_t toDevice, uint64_t fromDevice) {
+    if (!enabled.load(std::memory_order_relaxed)) return;
+    ThreadMetrics& m = local();
+    bump(m.openclBytesToDevice, toDevice);
+    bump(m.openclBytesFromDevice, fromDevice);
+}
+
+uint64_t md6TreeCompressions(uint64_t length) {
+    uint64_t nodes = (length == 0) ? 1 : (length + 511) / 512;
+    uint64_t total = nodes;
+    while (nodes > 1) {
+        nodes = (nodes + 3) / 4;
+        total += nodes;
+    }
+    return total;
+}
+
+Metrics metrics() {
+    Metrics m;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    m = retired;
+    for (const ThreadMetrics* t : live) t->addTo(m);
+    return m;
+}
+
+void resetMetrics() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    retired = Metrics();
+    for (ThreadMetrics* t : live) t->clear();
+}
+
+void setMetricsEnabled(bool on) {
+    enabled = on;
+}
+
+std::string metricsText() {
+    const Metrics m = metrics();
+    const char* algNames[2] = {"md5", "md6"};
+    std::string out;
+    char line[1024];
+
+    // Prometheus buckets at the powers of two from 256 ns to 2^34 ns, which are HDR bucket edges
+    out += "# HELP yoda_hash_duration_seconds Latency of hash, hashBatch and Hasher::final calls. Calls under "
+           "4 KiB are sampled 1 in 256 and weighted by 256.\n";
+    out += "# TYPE yoda_hash_duration_seconds histogram\n";
+    for (int a = 0; a < 2; a++) {
+        for (int e = 0; e < 6; e++) {
+            const EngineMetrics& em = m.engines[a][e];
+            if (em.calls == 0) continue;
+
+            int bucket = 0;
+            uint64_t cumulative = 0;
+            for (int power = 8; power <= 34; power++) {
+                while (bucket < Histogram::buckets && Histogram::lowerBound(bucket) < (1ULL << power)) {
+                    cumulative += em.latency.counts[bucket++];
+                }
+                snprintf(line, sizeof(line),
+                         "yoda_hash_duration_seconds_bucket{algorithm=\"%s\",engine=\"%s\",le=\"%g\"} %llu\n",
+                         algNames[a], engineName((Engine) e), (double) (1ULL << power) * 1e-9,
+                         (unsigned long long) cumulative);
+                out += line;
+            }
+            snprintf(line, sizeof(line),
+                     "yoda_hash_duration_seconds_bucket{algorithm=\"%s\",engine=\"%s\",le=\"+Inf\"} %llu\n"
+                     "yoda_hash_duration_seconds_sum{algorithm=\"%s\",engine=\"%s\"} %g\n"
+                     "yoda_hash_duration_seconds_count{algorithm=\"%s\",engine=\"%s\"} %llu\n",
+                     algNames[a], engineName((Engine) e), (unsigned long long) em.latency.count(),
+                     algNames[a], engineName((Engine) e), em.nanoseconds * 1e-9,
+                     algNames[a], engineName((Engine) e), (unsigned long long) em.latency.count());
+            out += line;
+        }
+    }
+
+    struct { const char* name; const char* help; uint64_t EngineMetrics::*field; } counters[] = {
+            {"yoda_calls_total", "Calls into the library. Estimate: calls under 4 KiB are sampled 1 in 256 "
+                                 "and weighted by 256.", &EngineMetrics::calls},
+            {"yoda_messages_total", "Messages hashed. Estimate: calls under 4 KiB are sampled 1 in 256 and "
+                                    "weighted by 256.", &EngineMetrics::messages},
+            {"yoda_bytes_total", "Message bytes hashed. Estimate: calls under 4 KiB are sampled 1 in 256 and "
+                                 "weighted by 256.", &EngineMetrics::bytes},
+    };
+    for (const auto& counter : counters) {
+        out += std::string("# HELP ") + counter.name + " " + counter.help + "\n";
+        out += std::string("# TYPE ") + counter.name + " counter\n";
+        for (int a = 0; a < 2; a++) {
+            for (int e = 0; e < 6; e++) {
+                const EngineMetrics& em = m.engines[a][e];
+                if (em.calls == 0) continue;
+                snprintf(line, sizeof(line), "%s{algorithm=\"%s\",engine=\"%s\"} %llu\n", counter.name, algNames[a],
+                         engineName((Engine) e), (unsigned long long) (em.*counter.field));
+                out += line;
+            }
+        }
+    }
+
+    snprintf(line, sizeof(line),
+             "# HELP yoda_md6_compressions_total MD6 compression function calls.\n"
+             "# TYPE yoda_md6_compressions_total counter\n"
+             "yoda_md6_compressions_total %llu\n"
+             "# HELP yoda_opencl_transfer_bytes_total Bytes copied between host and OpenCL device.\n"
+             "# TYPE yoda_opencl_transfer_bytes_total counter\n"
+             "yoda_opencl_transfer_bytes_total{direction=\"to_device\"} %llu\n"
+             "yoda_opencl_transfer_bytes_total{direction=\"from_device\"} %llu\n",
+             (unsigned long long) m.md6Compressions, (unsigned long long) m.openclBytesToDevice,
+             (unsigned long long) m.openclBytesFromDevice);
+    out += line;
+    return out;
+}
+
+}
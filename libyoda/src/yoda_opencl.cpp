@@ -0,0 +1,40 @@
+#include <memory>
+#include <mutex>
+#include "md6_opencl.h"
+#include "yoda_engines.h"
+#include "yoda_opencl.h"
+
+static std::unique_ptr<OpenCLResources> resources;
+static std::mutex resourcesMutex;  // One command queue, one message at a time
+
+bool yodaOpenCLProbe(std::string& device) {
+    std::lock_guard<std::mutex> lock(resourcesMutex);
+    if (resources) return true;
+
+    // Throws without a platform, a device or the kernel source
+    try {
+        resources.reset(new OpenCLResources());
+    } catch (const OpenCLError&) {
+        return false;
+    }
+
+    char name[256] = {0};
+    clGetDeviceInfo(resources->getDevice(), CL_DEVICE_NAME, sizeof(name) - 1, name, nullptr);
+    device = name;
+    return true;
+}
+
+bool yodaOpenCLHashMD6(const unsigned char* data, uint64_t length, const md6_state* params, unsigned char* hashval) {
+    std::lock_guard<std::mutex> lock(resourcesMutex);
+    if (!resources) return false;
+
+    try {
+        md6HashOpenCL(*resources, data, length, params, hashval);
+    } catch (const OpenCLError&) {
+        return false;
+    }
+
+    // The message and the N prefix go to the device, only the root chaining value comes back
+    yoda::metricsOpenCLTransfer(length + sizeof(params->N_prefix), md6_c * sizeof(md6_word));
+    return true;
+}
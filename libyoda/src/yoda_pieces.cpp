@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "yoda_engines.h"
+#include "yoda_pieces.h"
+
+namespace yoda {
+
+static const char pieceMagic[8] = {'Y', 'O', 'D', 'A', 'P', 'C', 'E', '1'};
+static const size_t pieceHeaderSize = sizeof(pieceMagic) + 1 + 2 * sizeof(uint64_t);
+
+// Digests of the pieces of one window, split between threads in runs of whole vector groups so that
+// only the last group of the window has a short piece
+static void hashWindow(Algorithm alg, const uint8_t* data, uint64_t length, uint64_t pieceSize,
+                       unsigned int threads, uint8_t* digests) {
+    const size_t digestLen = digestLength(alg);
+    size_t count = (length + pieceSize - 1) / pieceSize;
+    std::vector<const uint8_t*> pieces(count);
+    std::vector<size_t> lengths(count);
+    for (size_t i = 0; i < count; i++) {
+        pieces[i] = data + i * pieceSize;
+        lengths[i] = std::min(pieceSize, length - i * pieceSize);
+    }
+
+    MetricsToken token = metricsStart(length);
+    Engine engine = selectEngine(alg, pieceSize, count);
+
+    // The MD6 batch engine spreads over the cores by itself
+    if (alg == Algorithm::MD6 || threads <= 1 || count < 2 * (size_t) threads) {
+        engine = hashMany(alg, engine, pieces.data(), lengths.data(), count, digests);
+    } else {
+        size_t perThread = ((count + threads - 1) / threads + 7) / 8 * 8;
+        std::vector<std::thread> workers;
+        for (size_t first = 0; first < count; first += perThread) {
+            size_t n = std::min(perThread, count - first);
+            workers.emplace_back([&, first, n] {
+                hashMany(alg, engine, &pieces[first], &lengths[first], n, digests + first * digestLen);
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+    }
+    metricsRecord(token, alg, engine, count, length);
+}
+
+// Regular files: one mapping per window. The next window is prefetched while this one is hashed, and
+// hashed windows are dropped from the page cache so that a file larger than memory does not push
+// everything else out.
+static void hashMapped(int fd, uint64_t fileLength, Algorithm alg, uint64_t pieceSize, uint64_t windowSize,
+                       unsigned int threads, const PieceSink& sink, PieceStats& stats) {
+    const size_t digestLen = digestLength(alg);
+    const uint64_t page = (uint64_t) sysconf(_SC_PAGESIZE);
+    std::vector<uint8_t> digests((windowSize / pieceSize) * digestLen);
+
+    for (uint64_t offset = 0; offset < fileLength; offset += windowSize) {
+        uint64_t length = std::min(windowSize, fileLength - offset);
+        uint64_t mapOffset = offset / page * page;
+        size_t mapLength = (size_t) (length + offset - mapOffset);
+
+        void* map = mmap(nullptr, mapLength, PROT_READ, MAP_SHARED, fd, (off_t) mapOffset);
+        if (map == MAP_FAILED) {
+            stats.ok = false;
+            return;
+        }
+        madvise(map, mapLength, MADV_SEQUENTIAL);
+        if (offset + length < fileLength)
+            posix_fadvise(fd, (off_t) (offset + length), (off_t) std::min(windowSize, fileLength - offset - length),
+                          POSIX_FADV_WILLNEED);
+
+        hashWindow(alg, (const uint8_t*) map + (offset - mapOffset), length, pieceSize, threads, digests.data());
+        munmap(map, mapLength);
+        posix_fadvise(fd, (off_t) mapOffset, (off_t) mapLength, POSIX_FADV_DONTNEED);
+
+        size_t count = (length + pieceSize - 1) / pieceSize;
+        sink(stats.pieces, digests.data(), count);
+        stats.pieces += count;
+        stats.bytes += length;
+    }
+}
+
+// Anything else: whole windows are read, the next one while the previous is hashed
+static void hashRead(int fd, Algorithm alg, uint64_t pieceSize, uint64_t windowSize, unsigned int threads,
+                     const PieceSink& sink, PieceStats& stats) {
+    const size_t digestLen = digestLength(alg);
+    std::vector<uint8_t> windows[2], digests((windowSize / pieceSize) * digestLen);
+    std::future<void> hashing;
+    size_t hashingLength = 0;
+    bool end = false;
+
+    auto deliver = [&] {
+        hashing.get();
+        size_t count = (hashingLength + pieceSize - 1) / pieceSize;
+        sink(stats.pieces, digests.data(), count);
+        stats.pieces += count;
+        stats.bytes += hashingLength;
+    };
+
+    for (int k = 0; !end; k++) {
+        std::vector<uint8_t>& w = windows[k % 2];
+        w.resize(windowSize);
+
+        size_t filled = 0;
+        while (filled < w.size()) {
+            ssize_t n = read(fd, w.data() + filled, w.size() - filled);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                if (n < 0) stats.ok = false;
+                end = true;
+                break;
+            }
+            filled += n;
+        }
+
+        if (hashing.valid()) deliver();
+        if (filled > 0) {
+            hashingLength = filled;
+            hashing = std::async(std::launch::async, hashWindow, alg, w.data(), (uint64_t) filled, pieceSize,
+                                 threads, digests.data());
+        }
+    }
+    if (hashing.valid()) deliver();
+}
+
+PieceStats hashPieces(int fd, Algorithm alg, const PieceParams& params, const PieceSink& sink) {
+    PieceStats stats;
+    if (params.pieceSize == 0) return stats;
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t pieceSize = params.pieceSize;
+    uint64_t windowSize = std::max((uint64_t) 1, params.windowSize / pieceSize) * pieceSize;
+    unsigned int threads = params.threads ? params.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        stats.mapped = true;
+        hashMapped(fd, (uint64_t) st.st_size, alg, pieceSize, windowSize, threads, sink, stats);
+    } else {
+        hashRead(fd, alg, pieceSize, windowSize, threads, sink, stats);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+bool writePieceTable(int fd, const std::string& path, Algorithm alg, const PieceParams& params, PieceStats* stats) {
+    if (params.pieceSize == 0) return false;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    const size_t digestLen = digestLength(alg);
+    const uint8_t algByte = (alg == Algorithm::MD5) ? 0 : 1;
+    uint64_t length = 0;
+
+    // The length is filled in at the end, a stream's is only known then
+    bool ok = fwrite(pieceMagic, sizeof(pieceMagic), 1, file) == 1 && fwrite(&algByte, 1, 1, file) == 1 &&
+              fwrite(&params.pieceSize, sizeof(uint64_t), 1, file) == 1 &&
+              fwrite(&length, sizeof(length), 1, file) == 1;
+
+    PieceStats s = hashPieces(fd, alg, params, [&](uint64_t, const uint8_t* digests, size_t count) {
+        ok = ok && fwrite(digests, digestLen, count, file) == count;
+    });
+    length = s.bytes;
+
+    ok = ok && s.ok && fseek(file, pieceHeaderSize - sizeof(length), SEEK_SET) == 0 &&
+         fwrite(&length, sizeof(length), 1, file) == 1;
+    if (fclose(file) != 0) ok = false;
+
+    if (stats != nullptr) *stats = s;
+    return ok;
+}
+
+bool loadPieceTable(const std::string& path, PieceTable& table) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    char magic[sizeof(pieceMagic)];
+    uint8_t algByte = 0;
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, pieceMagic, sizeof(magic)) == 0 &&
+              fread(&algByte, 1, 1, file) == 1 && algByte <= 1 &&
+              fread(&table.pieceSize, sizeof(uint64_t), 1, file) == 1 && table.pieceSize > 0 &&
+              fread(&table.length, sizeof(uint64_t), 1, file) == 1;
+
+    if (ok) {
+        table.alg = algByte == 0 ? Algorithm::MD5 : Algorithm::MD6;
+        table.digests.resize(table.count() * digestLength(table.alg));
+        char extra;
+        ok = fread(table.digests.data(), 1, table.digests.size(), file) == table.digests.size() &&
+             fread(&extra, 1, 1, file) == 0;
+    }
+
+    fclose(file);
+    return ok;
+}
+
+}
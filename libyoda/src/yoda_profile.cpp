@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "yoda_engines.h"
+
+namespace yoda {
+
+static std::mutex profileMutex;
+static Profile current;
+static std::once_flag profileLoaded;
+
+// A calibrated crossover that never happened on this machine
+static const uint64_t never = UINT64_MAX;
+
+static bool readProfile(const std::string& path, Profile& p);
+
+static void loadDefaultProfile() {
+    const char* path = std::getenv("YODA_PROFILE");
+    Profile p;
+    if (path != nullptr && readProfile(path, p)) {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        current = p;
+    }
+}
+
+Profile profile() {
+    std::call_once(profileLoaded, loadDefaultProfile);
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return current;
+}
+
+void setProfile(const Profile& p) {
+    std::call_once(profileLoaded, [] {});  // An explicit profile wins over YODA_PROFILE
+    std::lock_guard<std::mutex> lock(profileMutex);
+    current = p;
+}
+
+bool saveProfile(const std::string& path, const Profile& p) {
+    std::ofstream file(path);
+    file << "# libyoda calibration profile, written by calibrate()\n";
+    file << "device " << p.device << "\n";
+    file << "md6_threaded_min_bytes " << p.md6ThreadedMinBytes << "\n";
+    file << "md6_opencl_min_bytes " << p.md6OpenCLMinBytes << "\n";
+    file << "md5_simd_min_batch " << p.md5SimdMinBatch << "\n";
+    file << "md6_threaded_min_batch " << p.md6ThreadedMinBatch << "\n";
+    file << "md6_cpu_bytes_per_second " << p.md6CpuBytesPerSecond << "\n";
+    file << "md6_opencl_bytes_per_second " << p.md6OpenCLBytesPerSecond << "\n";
+    return file.good();
+}
+
+static bool readProfile(const std::string& path, Profile& p) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+
+        if (key == "device") {
+            std::getline(fields >> std::ws, p.device);
+        } else if (key == "md6_threaded_min_bytes") {
+            fields >> p.md6ThreadedMinBytes;
+        } else if (key == "md6_opencl_min_bytes") {
+            fields >> p.md6OpenCLMinBytes;
+        } else if (key == "md5_simd_min_batch") {
+            fields >> p.md5SimdMinBatch;
+        } else if (key == "md6_threaded_min_batch") {
+            fields >> p.md6ThreadedMinBatch;
+        } else if (key == "md6_cpu_bytes_per_second") {
+            fields >> p.md6CpuBytesPerSecond;
+        } else if (key == "md6_opencl_bytes_per_second") {
+            fields >> p.md6OpenCLBytesPerSecond;
+        }
+    }
+
+    // Crossovers measured against another device do not hold here
+    return p.device == features().device;
+}
+
+bool loadProfile(const std::string& path) {
+    Profile p;
+    if (!readProfile(path, p)) return false;
+
+    setProfile(p);
+    return true;
+}
+
+// Seconds per call of fn, repeated until the measurement is long enough to trust
+static double timePerCall(const std::function<void()>& fn) {
+    const double minTime = 0.02;
+    int calls = 0;
+    std::chrono::duration<double> elapsed(0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    while (elapsed.count() < minTime) {
+        fn();
+        calls++;
+        elapsed = std::chrono::high_resolution_clock::now() - start;
+    }
+    return elapsed.count() / calls;
+}
+
+// Smallest size from which the candidate is faster than the baseline at every larger size measured
+static uint64_t crossover(const std::vector<uint64_t>& sizes, const std::vector<double>& baseline,
+                          const std::vector<double>& candidate) {
+    uint64_t from = never;
+    for (size_t k = sizes.size(); k-- > 0;) {
+        if (candidate[k] >= baseline[k]) break;
+        from = sizes[k];
+    }
+    return from;
+}
+
+static double timeMessage(Algorithm alg, Engine engine, const std::vector<uint8_t>& message) {
+    uint8_t digest[64];
+    return timePerCall([&] { hashOne(alg, engine, message.data(), message.size(), digest); });
+}
+
+static double timeBatch(Algorithm alg, Engine engine, const std::vector<uint8_t>& message, size_t count) {
+    std::vector<const uint8_t*> messages(count, message.data());
+    std::vector<size_t> lengths(count, message.size());
+    std::vector<uint8_t> digests(count * digestLength(alg));
+    return timePerCall([&] { hashMany(alg, engine, messages.data(), lengths.data(), count, digests.data()); });
+}
+
+Profile calibrate() {
+    const Features& f = features();
+    Profile p;
+    p.device = f.device;
+
+    // One MD6 message of growing size: scalar against the threaded tree, and the best CPU engine
+    // against the device
+    std::vector<uint64_t> sizes;
+    std::vector<double> scalar, threaded, cpu, device;
+    for (uint64_t size = 4 << 10; size <= (16 << 20); size *= 4) {
+        std::vector<uint8_t> message(size, 0x5a);
+        sizes.push_back(size);
+        scalar.push_back(timeMessage(Algorithm::MD6, Engine::Scalar, message));
+        threaded.push_back(f.cores > 1 ? timeMessage(Algorithm::MD6, Engine::Threaded, message) : scalar.back());
+        cpu.push_back(std::min(scalar.back(), threaded.back()));
+        device.push_back(f.opencl ? timeMessage(Algorithm::MD6, Engine::OpenCL, message) : cpu.back());
+    }
+
+    p.md6ThreadedMinBytes = crossover(sizes, scalar, threaded);
+    p.md6OpenCLMinBytes = crossover(sizes, cpu, device);
+    p.md6CpuBytesPerSecond = sizes.back() / cpu.back();
+    p.md6OpenCLBytesPerSecond = f.opencl ? sizes.back() / device.back() : 0;
+
+    // Batches of growing count of one-block messages
+    std::vector<uint8_t> shortMessage(55, 0x5a);
+    std::vector<uint64_t> counts;
+    std::vector<double> md5Scalar, md5Simd, md6Scalar, md6Threaded;
+    for (size_t count = 2; count <= 256; count *= 2) {
+        counts.push_back(count);
+        md5Scalar.push_back(timeBatch(Algorithm::MD5, Engine::Scalar, shortMessage, count));
+        md5Simd.push_back(f.sse2 ? timeBatch(Algorithm::MD5, Engine::SIMD, shortMessage, count) : md5Scalar.back());
+        md6Scalar.push_back(timeBatch(Algorithm::MD6, Engine::Scalar, shortMessage, count));
+        md6Threaded.push_back(f.cores > 1 ? timeBatch(Algorithm::MD6, Engine::Threaded, shortMessage, count)
+                                          : md6Scalar.back());
+    }
+
+    p.md5SimdMinBatch = crossover(counts, md5Scalar, md5Simd);
+    p.md6ThreadedMinBatch = crossover(counts, md6Scalar, md6Threaded);
+
+    return p;
+}
+
+}
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <unistd.h>
+#include "yoda_tar.h"
+
+namespace yoda {
+
+static const size_t tarBlock = 512;
+static const uint64_t maxExtensionSize = 1 << 20;  // GNU long names and pax headers are held in memory
+
+// Octal number field, NUL or space terminated, or base-256 (GNU) when the top bit of the first byte is set
+static bool parseNumber(const uint8_t* field, size_t length, uint64_t& value) {
+    value = 0;
+    if (field[0] & 0x80) {
+        value = field[0] & 0x7f;
+        for (size_t i = 1; i < length; i++) {
+            if (value >> 56) return false;
+            value = (value << 8) | field[i];
+        }
+        return true;
+    }
+
+    size_t i = 0;
+    while (i < length && field[i] == ' ') i++;
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; i++) value = (value << 3) | (field[i] - '0');
+    return i == length || field[i] == 0 || field[i] == ' ';
+}
+
+static std::string fieldString(const uint8_t* field, size_t length) {
+    return std::string((const char*) field, strnlen((const char*) field, length));
+}
+
+TarHasher::TarHasher(Algorithm alg)
+        : alg(alg), state(State::Header), fed(0), parsed(0), whole(new Hasher(alg)), blockFilled(0),
+          zeroBlocks(0), remaining(0), member(), extensionType(0), nextSize(0), hasNextSize(false) {
+}
+
+TarHasher::~TarHasher() = default;
+
+void TarHasher::update(const uint8_t* data, size_t length) {
+    fed += length;
+
+    // The whole-archive digest does not depend on the members, so large pieces hash it on another core
+    if (length >= (1 << 20) && std::thread::hardware_concurrency() > 1) {
+        std::future<void> archiveHash = std::async(std::launch::async, [&] { whole->update(data, length); });
+        parse(data, length);
+        archiveHash.get();
+    } else {
+        whole->update(data, length);
+        parse(data, length);
+    }
+}
+
+void TarHasher::parse(const uint8_t* data, size_t length) {
+    while (length > 0 && state != State::End && state != State::Failed) {
+        size_t n = 0;
+        switch (state) {
+            case State::Header:
+                // Headers are the only bytes copied, as one may be split between two pieces
+                n = std::min(tarBlock - blockFilled, length);
+                memcpy(block + blockFilled, data, n);
+                blockFilled += n;
+                parsed += n;
+                if (blockFilled == tarBlock) {
+                    blockFilled = 0;
+                    header();
+                }
+                break;
+
+            case State::Data:
+                n = (size_t) std::min((uint64_t) length, remaining);
+                if (memberHasher) memberHasher->update(data, n);
+                else if (extensionType) extension.append((const char*) data, n);
+                remaining -= n;
+                parsed += n;
+                if (remaining == 0) endMember();
+                break;
+
+            case State::Padding:
+                n = (size_t) std::min((uint64_t) length, remaining);
+                remaining -= n;
+                parsed += n;
+                if (remaining == 0) state = State::Header;
+                break;
+
+            default:
+                break;
+        }
+        data += n;
+        length -= n;
+    }
+}
+
+void TarHasher::header() {
+    bool zero = true;
+    for (size_t i = 0; i < tarBlock && zero; i++) zero = block[i] == 0;
+    if (zero) {
+        if (++zeroBlocks == 2) state = State::End;
+        return;
+    }
+    zeroBlocks = 0;
+
+    // The checksum is the sum of the header bytes with its own field counted as spaces
+    uint64_t stored, sum = 0, size;
+    for (size_t i = 0; i < tarBlock; i++) sum += (i >= 148 && i < 156) ? ' ' : block[i];
+    if (!parseNumber(block + 148, 8, stored) || stored != sum) {
+        fail("bad header checksum at offset " + std::to_string(parsed - tarBlock));
+        return;
+    }
+    if (!parseNumber(block + 124, 12, size)) {
+        fail("bad member size at offset " + std::to_string(parsed - tarBlock));
+        return;
+    }
+
+    char type = (char) block[156];
+    std::string name = fieldString(block, 100);
+    if (memcmp(block + 257, "ustar", 5) == 0 && block[345] != 0) name = fieldString(block + 345, 155) + "/" + name;
+
+    if (type == 'L' || type == 'K' || type == 'x' || type == 'g') {
+        // Extension headers: their data describes the next member (long link names and global pax
+        // records are collected and ignored)
+        if (size > maxExtensionSize) {
+            fail("oversized extension header at offset " + std::to_string(parsed - tarBlock));
+            return;
+        }
+        extensionType = type;
+        extension.clear();
+    } else {
+        if (!nextName.empty()) name = nextName;
+        if (hasNextSize) size = nextSize;
+        nextName.clear();
+        hasNextSize = false;
+
+        member = TarMember{name, type, size, parsed, Digest()};
+        if (type == '0' || type == '\0' || type == '7') memberHasher.reset(new Hasher(alg));
+    }
+
+    remaining = size;
+    if (size == 0) endMember();
+    else state = State::Data;
+}
+
+void TarHasher::endMember() {
+    if (extensionType) {
+        if (extensionType == 'L') {
+            nextName = fieldString((const uint8_t*) extension.data(), extension.size());
+        } else if (extensionType == 'x') {
+            // Records of "<length> <key>=<value>\n"
+            size_t pos = 0;
+            while (pos < extension.size()) {
+                size_t space = extension.find(' ', pos);
+                size_t length = (space == std::string::npos) ? 0 : strtoull(extension.c_str() + pos, nullptr, 10);
+                if (length == 0 || pos + length > extension.size()) break;
+
+                std::string record = extension.substr(space + 1, pos + length - space - 2);
+                size_t equals = record.find('=');
+                if (equals != std::string::npos) {
+                    std::string key = record.substr(0, equals);
+                    if (key == "path") nextName = record.substr(equals + 1);
+                    if (key == "size") {
+                        nextSize = strtoull(record.c_str() + equals + 1, nullptr, 10);
+                        hasNextSize = true;
+                    }
+                }
+                pos += length;
+            }
+        }
+        extensionType = 0;
+        extension.clear();
+    } else {
+        if (memberHasher) {
+            member.digest = memberHasher->final();
+            memberHasher.reset();
+        }
+        done.push_back(member);
+    }
+
+    // Data is padded to whole blocks
+    uint64_t padding = (tarBlock - parsed % tarBlock) % tarBlock;
+    remaining = padding;
+    state = padding ? State::Padding : State::Header;
+}
+
+void TarHasher::fail(const std::string& message) {
+    problem = message;
+    state = State::Failed;
+    memberHasher.reset();
+}
+
+void TarHasher::streamFailed(const std::string& message) {
+    if (state != State::Failed) fail(message);
+}
+
+bool TarHasher::finish() {
+    if (archive.empty()) archive = whole->final();
+
+    // A stream that stops at a block boundary without the two zero blocks is accepted, as GNU tar does
+    if (state == State::Header && blockFilled != 0) fail("archive truncated in a header");
+    if (state == State::Data || state == State::Padding)
+        fail("archive truncated in " + (extensionType ? std::string("an extension header") : member.name));
+    return state != State::Failed;
+}
+
+TarStats hashTarStream(int fd, TarHasher& tar) {
+    const size_t windowSize = 16 << 20;
+    TarStats stats;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> windows[2];
+    std::future<void> hashing;
+    bool end = false;
+    int readError = 0;
+
+    for (int k = 0; !end; k++) {
+        std::vector<uint8_t>& w = windows[k % 2];
+        w.resize(windowSize);
+
+        size_t filled = 0;
+        while (filled < w.size()) {
+            ssize_t n = read(fd, w.data() + filled, w.size() - filled);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                if (n < 0) readError = errno;
+                end = true;
+                break;
+            }
+            filled += n;
+        }
+
+        // This window was read while the previous one was hashed
+        if (hashing.valid()) hashing.get();
+        if (filled > 0) hashing = std::async(std::launch::async, [&tar, &w, filled] { tar.update(w.data(), filled); });
+    }
+    if (hashing.valid()) hashing.get();
+
+    // A stream cut short by an error can end on a block boundary, which would pass as a whole archive
+    if (readError != 0) {
+        stats.ok = false;
+        tar.streamFailed("read error after " + std::to_string(tar.archiveBytes()) + " bytes: " + strerror(readError));
+    }
+    tar.finish();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    stats.bytes = tar.archiveBytes();
+    stats.members = tar.members().size();
+    stats.seconds = elapsed.count();
+    return stats;
+}
+
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "yoda.h"
+#include "yoda_chunk.h"
+#include "yoda_metrics.h"
+
+using yoda::Algorithm;
+using yoda::Engine;
+
+static void printFeatures() {
+    const yoda::Features& f = yoda::features();
+    std::cout << "CPU: sse2 " << (f.sse2 ? "yes" : "no") << ", avx2 " << (f.avx2 ? "yes" : "no")
+              << ", " << f.cores << " core(s)\n";
+    std::cout << "OpenCL: " << (f.opencl ? f.device : std::string("no device")) << "\n";
+
+    std::cout << "Engine for one MD6 message of 1 KiB / 16 MiB / 1 GiB: "
+              << yoda::engineName(yoda::selectEngine(Algorithm::MD6, 1 << 10)) << " / "
+              << yoda::engineName(yoda::selectEngine(Algorithm::MD6, 16 << 20)) << " / "
+              << yoda::engineName(yoda::selectEngine(Algorithm::MD6, 1ULL << 30)) << "\n";
+    std::cout << "Engine for 1 / 1000 MD5 messages: "
+              << yoda::engineName(yoda::selectEngine(Algorithm::MD5, 64, 1)) << " / "
+              << yoda::engineName(yoda::selectEngine(Algorithm::MD5, 64, 1000)) << "\n";
+}
+
+static std::string crossoverText(uint64_t value) {
+    return value == UINT64_MAX ? "never" : std::to_string(value);
+}
+
+static void printProfile(const yoda::Profile& p) {
+    std::cout << "MD6 threaded from " << crossoverText(p.md6ThreadedMinBytes) << " bytes, OpenCL from "
+              << crossoverText(p.md6OpenCLMinBytes) << " bytes\n";
+    std::cout << "MD5 SIMD from " << crossoverText(p.md5SimdMinBatch) << " messages, MD6 threaded batch from "
+              << crossoverText(p.md6ThreadedMinBatch) << " messages\n";
+    std::cout << "MD6 CPU " << p.md6CpuBytesPerSecond / 1e6 << " MB/s, OpenCL "
+              << p.md6OpenCLBytesPerSecond / 1e6 << " MB/s\n";
+}
+
+// Every engine must agree with the scalar one, for single messages, batches and streams
+static void singleTest() {
+    const std::string fox = "The quick brown fox jumps over the lazy dog";
+    const std::string knownMD5 = "9e107d9d372bb6826bd81d3542a419d6";
+    bool ok = true;
+
+    ok &= yoda::toHex(yoda::hash(Algorithm::MD5, fox)) == knownMD5;
+    yoda::Hasher hasher(Algorithm::MD5);
+    hasher.update(fox.substr(0, 10));
+    hasher.update(fox.substr(10));
+    ok &= yoda::toHex(hasher.final()) == knownMD5;
+
+    std::mt19937 rng(4120);
+    std::vector<std::string> messages(1000);
+    for (std::string& message : messages) {
+        message.resize(rng() % 300);
+        for (char& ch : message) ch = (char) rng();
+    }
+
+    const Engine engines[4] = {Engine::Scalar, Engine::SIMD, Engine::Threaded, Engine::OpenCL};
+    for (Algorithm alg : {Algorithm::MD5, Algorithm::MD6}) {
+        const char* name = (alg == Algorithm::MD5) ? "MD5" : "MD6";
+
+        yoda::setEngine(Engine::Scalar);
+        std::vector<yoda::Digest> expected = yoda::hashBatch(alg, messages);
+        std::string longMessage(3 << 20, 'a');
+        yoda::Digest expectedLong = yoda::hash(alg, longMessage);
+
+        for (Engine engine : engines) {
+            yoda::setEngine(engine);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            bool batchOk = yoda::hashBatch(alg, messages) == expected;
+            Engine batchEngine = yoda::lastEngine();
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+
+            bool longOk = yoda::hash(alg, longMessage) == expectedLong;
+            Engine longEngine = yoda::lastEngine();
+
+            std::cout << name << " forced " << yoda::engineName(engine) << ": batch on "
+                      << yoda::engineName(batchEngine) << " " << diff.count() * 1e9 / messages.size()
+                      << " ns/message" << (batchOk ? "" : " (DIGEST MISMATCH)") << ", 3 MiB on "
+                      << yoda::engineName(longEngine) << (longOk ? "" : " (DIGEST MISMATCH)") << "\n";
+            ok &= batchOk && longOk;
+        }
+    }
+    yoda::setEngine(Engine::Auto);
+
+    std::cout << (ok ? "All engines agree." : "Engines disagree!") << std::endl;
+}
+
+// Messages past 512 MiB, where a 32-bit bit count wraps: the scalar engine, the threaded one and a
+// Hasher fed in uneven pieces must give the same MD6 digest
+static bool largeMessageTest() {
+    std::vector<uint8_t> message((size_t) 520 << 20);
+    std::mt19937 rng(4120);
+    for (size_t i = 0; i < message.size(); i += 4096) message[i] = (uint8_t) rng();
+
+    yoda::setEngine(Engine::Scalar);
+    yoda::Digest scalar = yoda::hash(Algorithm::MD6, message.data(), message.size());
+    yoda::setEngine(Engine::Threaded);
+    yoda::Digest threaded = yoda::hash(Algorithm::MD6, message.data(), message.size());
+    yoda::setEngine(Engine::Auto);
+
+    yoda::Hasher hasher(Algorithm::MD6);
+    const size_t pieces[3] = {(size_t) 300 << 20, 12345, 0};
+    size_t offset = 0;
+    for (size_t piece : pieces) {
+        size_t n = piece ? piece : message.size() - offset;
+        hasher.update(message.data() + offset, n);
+        offset += n;
+    }
+    yoda::Digest streamed = hasher.final();
+
+    bool ok = scalar == threaded && scalar == streamed;
+    std::cout << "MD6 of 520 MiB: " << yoda::toHex(scalar) << (scalar == threaded ? "" : " (THREADED MISMATCH)")
+              << (scalar == streamed ? "" : " (STREAM MISMATCH)") << "\n";
+    return ok;
+}
+
+// A chunk index whose last record was cut short by a crash: reopening must drop the torn bytes, keep
+// every whole record and leave later appends aligned
+static bool indexRepairTest() {
+    const std::string path = "/tmp/yoda_index_test." + std::to_string(std::random_device()());
+    const size_t digestLen = 16, recordLen = 4 + digestLen;
+    std::vector<yoda::Digest> digests;
+    for (int i = 0; i < 5; i++) digests.push_back(yoda::hash(Algorithm::MD5, std::to_string(i)));
+
+    bool ok = true;
+    yoda::ChunkIndex index;
+    ok &= index.open(path, Algorithm::MD5);
+    for (int i = 0; i < 3; i++) ok &= index.insert(digests[i].data(), 100);
+    index.close();
+
+    FILE* file = fopen(path.c_str(), "ab");
+    ok &= file != nullptr && fwrite("torn!", 1, 5, file) == 5;
+    if (file != nullptr) fclose(file);
+
+    ok &= index.open(path, Algorithm::MD5) && index.size() == 3;
+    for (int i = 0; i < 3; i++) ok &= !index.insert(digests[i].data(), 100);
+    for (int i = 3; i < 5; i++) ok &= index.insert(digests[i].data(), 100);
+    index.close();
+
+    ok &= index.open(path, Algorithm::MD5) && index.size() == 5;
+    for (int i = 0; i < 5; i++) ok &= !index.insert(digests[i].data(), 100);
+    index.close();
+
+    file = fopen(path.c_str(), "rb");
+    long length = -1;
+    if (file != nullptr && fseek(file, 0, SEEK_END) == 0) length = ftell(file);
+    if (file != nullptr) fclose(file);
+    ok &= length == (long) (9 + 5 * recordLen);
+    remove(path.c_str());
+
+    std::cout << (ok ? "Torn index record dropped, whole records kept." : "Torn index record mishandled!") << "\n";
+    return ok;
+}
+
+// Worst case for the metrics: the shortest calls, where recording costs most relative to the hash.
+// Fails at 1% or more.
+static bool metricsOverhead() {
+    const std::string message(64, 'x');
+    const int calls = 20000;
+    std::vector<double> times[2], ratios;
+
+    // Short rounds in pairs, the order alternating, compared by the median ratio within a pair, so that
+    // drift in the clock speed and other load on the machine cancel out
+    for (int i = 0; i < calls; i++) yoda::hash(Algorithm::MD5, message);
+    for (int pair = 0; pair < 100; pair++) {
+        for (int k = 0; k < 2; k++) {
+            bool on = (pair + k) % 2 == 0;
+            yoda::setMetricsEnabled(on);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < calls; i++) yoda::hash(Algorithm::MD5, message);
+            std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+            times[on].push_back(diff.count());
+        }
+        ratios.push_back(times[1].back() / times[0].back());
+    }
+    yoda::setMetricsEnabled(true);
+
+    for (std::vector<double>* v : {&times[0], &times[1], &ratios}) std::sort(v->begin(), v->end());
+    double overhead = (ratios[ratios.size() / 2] - 1) * 100;
+    bool ok = overhead < 1;
+    std::cout << "MD5 of 64 bytes: " << times[0][times[0].size() / 2] * 1e9 / calls << " ns without metrics, "
+              << times[1][times[1].size() / 2] * 1e9 / calls << " ns with, overhead " << overhead << "%"
+              << (ok ? "" : " (OVER 1%)") << "\n";
+    return ok;
+}
+
+// Short keys: the scalar engine against the multi-buffer one on equal lengths (one specialised block
+// per group) and on lengths alternating by a byte (the general lane code)
+static void shortMessageBenchmark() {
+    const size_t count = 4096;
+    const int rounds = 50;
+    std::vector<uint8_t> keys(count * 64);
+    std::mt19937 rng(4120);
+    for (uint8_t& byte : keys) byte = rng();
+
+    std::vector<const uint8_t*> messages(count);
+    for (size_t i = 0; i < count; i++) messages[i] = keys.data() + i * 64;
+
+    auto nsPerHash = [&](Engine engine, const std::vector<size_t>& lengths) {
+        yoda::setEngine(engine);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            yoda::hashBatch(Algorithm::MD5, messages.data(), lengths.data(), count);
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        return diff.count() * 1e9 / (rounds * count);
+    };
+
+    for (size_t length : {16, 32, 55}) {
+        std::vector<size_t> equal(count, length), mixed(count, length);
+        for (size_t i = 1; i < count; i += 2) mixed[i] = length - 1;
+        std::cout << "MD5 of " << length << "-byte keys: scalar " << nsPerHash(Engine::Scalar, equal)
+                  << " ns/hash, simd equal lengths " << nsPerHash(Engine::SIMD, equal)
+                  << " ns/hash, simd mixed lengths " << nsPerHash(Engine::SIMD, mixed) << " ns/hash\n";
+    }
+    yoda::setEngine(Engine::Auto);
+}
+
+// yoda                       engine diagnostics and cross-engine verification
+// yoda md5|md6 <string>...   hash the arguments and report the engine used
+// yoda --calibrate <file>    measure the engine crossovers on this machine and save them
+// yoda --metrics             run the diagnostics, then print the metrics in Prometheus text format;
+//                            fails if recording them costs 1% or more
+// yoda --short               time the short-message MD5 paths in ns/hash
+// yoda --large               check MD6 of a 520 MiB message on every CPU path
+// yoda --index               check that a chunk index with a torn last record reopens cleanly
+int main(int argc, char** argv) {
+    if (argc == 2 && std::string(argv[1]) == "--metrics") {
+        singleTest();
+        bool ok = metricsOverhead();
+        std::cout << yoda::metricsText();
+        return ok ? 0 : 1;
+    }
+
+    if (argc == 2 && std::string(argv[1]) == "--short") {
+        shortMessageBenchmark();
+        return 0;
+    }
+
+    if (argc == 2 && std::string(argv[1]) == "--large") return largeMessageTest() ? 0 : 1;
+    if (argc == 2 && std::string(argv[1]) == "--index") return indexRepairTest() ? 0 : 1;
+
+    if (argc == 3 && std::string(argv[1]) == "--calibrate") {
+        yoda::Profile p = yoda::calibrate();
+        printProfile(p);
+        if (!yoda::saveProfile(argv[2], p)) {
+            std::cerr << "Could not write " << argv[2] << "\n";
+            return 1;
+        }
+        std::cout << "Saved to " << argv[2] << ", load it with YODA_PROFILE=" << argv[2] << "\n";
+        return 0;
+    }
+
+    if (argc >= 2) {
+        std::string alg = argv[1];
+        if (alg != "md5" && alg != "md6") {
+            std::cerr << "Usage: " << argv[0] << " [md5|md6 <string>... | --calibrate <file> | --metrics | --short | --large | --index]\n";
+            return 1;
+        }
+
+        for (int i = 2; i < argc; i++) {
+            yoda::Digest digest = yoda::hash(alg == "md5" ? Algorithm::MD5 : Algorithm::MD6, std::string(argv[i]));
+            std::cout << yoda::toHex(digest) << "  " << argv[i] << " ("
+                      << yoda::engineName(yoda::lastEngine()) << ")\n";
+        }
+        return 0;
+    }
+
+    printFeatures();
+    printProfile(yoda::profile());
+    singleTest();
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "yoda_async.h"
+
+using yoda::Algorithm;
+using yoda::Digest;
+using yoda::Task;
+
+// Everything below runs on one loop thread, driven the way a service with its own poll loop would
+// drive it, so the longest runReady() call is the longest the service would have been stalled.
+struct Loop {
+    yoda::EventLoop loop;
+    yoda::WorkerPool pool;
+    size_t inFlight = 0;
+    size_t maxInFlight = 0;
+    double longestStallMs = 0;
+
+    void run() {
+        while (loop.active() > 0) {
+            pollfd p{loop.fd(), POLLIN, 0};
+            poll(&p, 1, -1);
+            auto start = std::chrono::steady_clock::now();
+            loop.runReady();
+            std::chrono::duration<double, std::milli> stall = std::chrono::steady_clock::now() - start;
+            longestStallMs = std::max(longestStallMs, stall.count());
+        }
+    }
+};
+
+static Digest hashFileBlocking(Algorithm alg, const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    yoda::Hasher hasher(alg);
+    while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+        hasher.update((const uint8_t*) buffer.data(), in.gcount());
+    }
+    return hasher.final();
+}
+
+static Task<void> checkFile(Loop& l, Algorithm alg, std::string path, Digest expected, yoda::CancelToken token,
+                            size_t& done, size_t& cancelled, size_t& failed) {
+    l.maxInFlight = std::max(l.maxInFlight, ++l.inFlight);
+    Digest digest = co_await yoda::hashFileAsync(l.loop, l.pool, alg, path, token);
+    l.inFlight--;
+
+    if (digest.empty() && token.cancelled()) cancelled++;
+    else if (digest != expected) failed++;
+    else done++;
+}
+
+static Task<void> checkBatch(Loop& l, Algorithm alg, std::vector<std::string> messages,
+                             const std::vector<Digest>& expected, size_t& failed) {
+    l.maxInFlight = std::max(l.maxInFlight, ++l.inFlight);
+    std::vector<Digest> digests = co_await yoda::hashBatchAsync(l.loop, l.pool, alg, std::move(messages));
+    l.inFlight--;
+    if (digests != expected) failed++;
+}
+
+// Files: all of them in flight at once against hashing them one by one with blocking reads, then
+// the same with every other request cancelled while in flight (as when its client goes away). Batches: thousands of small batches in
+// flight at once.
+// yoda_async [md5|md6] [files] [batches]
+int main(int argc, char** argv) {
+    Algorithm alg = (argc > 1 && std::string(argv[1]) == "md6") ? Algorithm::MD6 : Algorithm::MD5;
+    size_t fileCount = argc > 2 ? std::stoul(argv[2]) : 2000;
+    size_t batchCount = argc > 3 ? std::stoul(argv[3]) : 4000;
+
+    const std::string dir = "/tmp/yoda_async_bench";
+    mkdir(dir.c_str(), 0755);
+    std::mt19937 rng(4120);
+    std::vector<std::string> paths;
+    uint64_t totalBytes = 0;
+    for (size_t i = 0; i < fileCount; i++) {
+        std::string content(1024 + rng() % (256 << 10), '\0');
+        for (char& ch : content) ch = (char) rng();
+        paths.push_back(dir + "/file" + std::to_string(i));
+        std::ofstream(paths.back(), std::ios::binary).write(content.data(), content.size());
+        totalBytes += content.size();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Digest> expected;
+    for (const std::string& path : paths) expected.push_back(hashFileBlocking(alg, path));
+    std::chrono::duration<double> blocking = std::chrono::steady_clock::now() - start;
+    printf("%zu files, %.1f MiB: blocking one at a time %.1f ms\n", fileCount, totalBytes / 1048576.0,
+           blocking.count() * 1e3);
+
+    bool anyFailed = false;
+    for (bool cancel : {false, true}) {
+        Loop l;
+        std::vector<yoda::CancelToken> tokens(fileCount);
+        size_t done = 0, cancelled = 0, failed = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < fileCount; i++) {
+            l.loop.spawn(checkFile(l, alg, paths[i], expected[i], tokens[i], done, cancelled, failed));
+        }
+        for (size_t i = 1; cancel && i < fileCount; i += 2) tokens[i].cancel();
+        l.run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        printf("%s: %.1f ms, %zu in flight at most, %zu done, %zu cancelled, longest loop stall %.2f ms%s\n",
+               cancel ? "async, half cancelled" : "async", elapsed.count() * 1e3, l.maxInFlight, done,
+               cancelled, l.longestStallMs, failed > 0 ? " (FAILED)" : "");
+        anyFailed = anyFailed || failed > 0;
+    }
+
+    for (const std::string& path : paths) std::remove(path.c_str());
+    rmdir(dir.c_str());
+
+    // Small batches of 64-byte messages
+    std::vector<std::vector<std::string>> batches(batchCount);
+    std::vector<std::vector<Digest>> batchDigests(batchCount);
+    for (size_t b = 0; b < batchCount; b++) {
+        batches[b].resize(16);
+        for (std::string& message : batches[b]) {
+            message.resize(64);
+            for (char& ch : message) ch = (char) rng();
+            batchDigests[b].push_back(yoda::hash(alg, message));
+        }
+    }
+
+    Loop l;
+    size_t failed = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < batchCount; b++) l.loop.spawn(checkBatch(l, alg, batches[b], batchDigests[b], failed));
+    l.run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%zu batches of 16: %.1f ms, %.0f hashes/s, %zu in flight at most, longest loop stall %.2f ms%s\n",
+           batchCount, elapsed.count() * 1e3, batchCount * 16 / elapsed.count(), l.maxInFlight, l.longestStallMs,
+           failed > 0 ? " (FAILED)" : "");
+
+    return (anyFailed || failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "yoda_chunk.h"
+
+using yoda::Algorithm;
+
+static void printStats(const std::string& name, const yoda::DedupStats& s) {
+    printf("%-24s %10.1f MB %8llu chunks %8llu new  dedup %5.2fx  %6.3f GB/s\n", name.c_str(), s.bytes / 1e6,
+           (unsigned long long) s.chunks, (unsigned long long) s.uniqueChunks, s.ratio(),
+           s.seconds > 0 ? s.bytes / s.seconds / 1e9 : 0);
+}
+
+// yoda_dedup md5|md6 <index file> [file...]
+// Chunks each file (standard input without any), hashes the chunks and adds the new ones to the index
+int main(int argc, char** argv) {
+    if (argc < 3 || (std::string(argv[1]) != "md5" && std::string(argv[1]) != "md6")) {
+        std::cerr << "Usage: " << argv[0] << " md5|md6 <index file> [file...]\n";
+        return 1;
+    }
+    Algorithm alg = std::string(argv[1]) == "md5" ? Algorithm::MD5 : Algorithm::MD6;
+
+    yoda::ChunkIndex index;
+    if (!index.open(argv[2], alg)) {
+        std::cerr << "Could not open index " << argv[2] << " (or it holds the other algorithm)\n";
+        return 1;
+    }
+    std::cout << "Index holds " << index.size() << " chunks\n";
+
+    yoda::DedupStats total;
+    int status = 0;
+    for (int i = 3; i < argc || i == 3; i++) {
+        int fd = (i < argc) ? open(argv[i], O_RDONLY) : STDIN_FILENO;
+        if (fd < 0) {
+            std::cerr << "Could not open " << argv[i] << "\n";
+            continue;
+        }
+
+        yoda::DedupStats s = yoda::dedupStream(fd, alg, index);
+        if (fd != STDIN_FILENO) close(fd);
+        printStats(i < argc ? argv[i] : "-", s);
+        if (!s.ok) {
+            std::cerr << "Read error in " << (i < argc ? argv[i] : "-") << ", only the chunks before it were indexed\n";
+            status = 1;
+        }
+
+        total.bytes += s.bytes;
+        total.chunks += s.chunks;
+        total.uniqueBytes += s.uniqueBytes;
+        total.uniqueChunks += s.uniqueChunks;
+        total.seconds += s.seconds;
+    }
+    if (argc > 4) printStats("total", total);
+    return status;
+}
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "yoda_daemon.h"
+
+using yoda::Algorithm;
+
+// Each client connects on its own thread and sends requests back to back, so the concurrency is
+// the number of requests the daemon can coalesce at once. Every digest is checked against the
+// library hashing in-process.
+// yoda_load [socket] [md5|md6] [max clients] [requests per client] [message bytes]
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : yoda::defaultSocketPath;
+    Algorithm alg = (argc > 2 && std::string(argv[2]) == "md6") ? Algorithm::MD6 : Algorithm::MD5;
+    int maxClients = argc > 3 ? std::stoi(argv[3]) : 64;
+    int requests = argc > 4 ? std::stoi(argv[4]) : 2000;
+    size_t bytes = argc > 5 ? std::stoul(argv[5]) : 64;
+
+    std::mt19937 rng(4120);
+    std::vector<std::string> messages(16);
+    std::vector<yoda::Digest> expected;
+    for (std::string& message : messages) {
+        message.resize(bytes);
+        for (char& ch : message) ch = (char) rng();
+        expected.push_back(yoda::hash(alg, message));
+    }
+
+    std::cout << "clients  requests/s   p50 us   p99 us  engine" << std::endl;
+    for (int clients = 1; clients <= maxClients; clients *= 2) {
+        std::vector<std::vector<double>> latencies(clients);
+        std::vector<yoda::Engine> engines(clients, yoda::Engine::Scalar);
+        std::atomic<int> failures{0};
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back([&, c] {
+                yoda::DaemonClient client;
+                if (!client.connect(path)) {
+                    failures++;
+                    return;
+                }
+                latencies[c].reserve(requests);
+                yoda::Digest digest;
+                for (int i = 0; i < requests; i++) {
+                    const std::string& message = messages[(c + i) % messages.size()];
+                    auto sent = std::chrono::steady_clock::now();
+                    bool ok = client.hash(alg, (const uint8_t*) message.data(), message.size(), digest);
+                    std::chrono::duration<double, std::micro> latency = std::chrono::steady_clock::now() - sent;
+
+                    if (!ok || digest != expected[(c + i) % messages.size()]) failures++;
+                    if (!ok) return;
+                    latencies[c].push_back(latency.count());
+                }
+                engines[c] = client.lastEngine();
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::vector<double> all;
+        for (const std::vector<double>& l : latencies) all.insert(all.end(), l.begin(), l.end());
+        if (all.empty()) {
+            std::cerr << "No responses from " << path << "\n";
+            return 1;
+        }
+        std::sort(all.begin(), all.end());
+
+        printf("%7d %11.0f %8.1f %8.1f  %s", clients, all.size() / elapsed.count(), all[all.size() / 2],
+               all[std::min(all.size() - 1, all.size() * 99 / 100)], yoda::engineName(engines[0]));
+        if (failures > 0) printf("  (%d FAILED)", failures.load());
+        printf("\n");
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "yoda_pieces.h"
+
+using yoda::Algorithm;
+
+static void printStats(const yoda::PieceStats& s) {
+    fprintf(stderr, "%.1f MB, %llu pieces (%s), %.3f GB/s\n", s.bytes / 1e6, (unsigned long long) s.pieces,
+            s.mapped ? "mapped" : "read", s.seconds > 0 ? s.bytes / s.seconds / 1e9 : 0);
+}
+
+// yoda_pieces md5|md6 [-p <piece KiB>] [-j <threads>] <table> [file]
+//     writes the piece table of a file (standard input without one)
+// yoda_pieces -c [-j <threads>] <table> [file]
+//     re-hashes the file with the table's algorithm and piece size and lists the pieces that differ
+int main(int argc, char** argv) {
+    bool check = argc > 1 && std::string(argv[1]) == "-c";
+    if (argc < 3 || (!check && std::string(argv[1]) != "md5" && std::string(argv[1]) != "md6")) {
+        std::cerr << "Usage: " << argv[0] << " md5|md6 [-p <piece KiB>] [-j <threads>] <table> [file]\n"
+                  << "       " << argv[0] << " -c [-j <threads>] <table> [file]\n";
+        return 1;
+    }
+    Algorithm alg = std::string(argv[1]) == "md6" ? Algorithm::MD6 : Algorithm::MD5;
+
+    yoda::PieceParams params;
+    std::string tablePath, filePath;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) params.pieceSize = std::stoull(argv[++i]) << 10;
+        else if (arg == "-j" && i + 1 < argc) params.threads = std::stoul(argv[++i]);
+        else if (tablePath.empty()) tablePath = arg;
+        else filePath = arg;
+    }
+    if (tablePath.empty() || params.pieceSize == 0) {
+        std::cerr << "A table path and a piece size of at least 1 KiB are needed\n";
+        return 1;
+    }
+
+    int fd = filePath.empty() || filePath == "-" ? STDIN_FILENO : open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open " << filePath << "\n";
+        return 1;
+    }
+
+    int status = 0;
+    if (!check) {
+        yoda::PieceStats stats;
+        if (!yoda::writePieceTable(fd, tablePath, alg, params, &stats)) {
+            std::cerr << "Could not write " << tablePath << " (or read the whole file)\n";
+            status = 1;
+        }
+        printStats(stats);
+    } else {
+        yoda::PieceTable table;
+        if (!yoda::loadPieceTable(tablePath, table)) {
+            std::cerr << "Could not read piece table " << tablePath << "\n";
+            if (fd != STDIN_FILENO) close(fd);
+            return 1;
+        }
+
+        params.pieceSize = table.pieceSize;
+        const size_t digestLen = table.digests.size() / std::max((size_t) 1, table.count());
+        uint64_t bad = 0;
+        yoda::PieceStats stats = yoda::hashPieces(fd, table.alg, params, [&](uint64_t first, const uint8_t* digests,
+                                                                              size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                uint64_t piece = first + i;
+                if (piece >= table.count() ||
+                    memcmp(digests + i * digestLen, &table.digests[piece * digestLen], digestLen) != 0) {
+                    printf("piece %llu: FAILED\n", (unsigned long long) piece);
+                    bad++;
+                }
+            }
+        });
+
+        if (stats.bytes < table.length) {
+            printf("file is %llu bytes short of the table's %llu\n",
+                   (unsigned long long) (table.length - stats.bytes), (unsigned long long) table.length);
+        }
+        printf("%llu of %llu pieces failed\n", (unsigned long long) bad, (unsigned long long) table.count());
+        printStats(stats);
+        status = (bad == 0 && stats.ok && stats.bytes == table.length) ? 0 : 1;
+    }
+
+    if (fd != STDIN_FILENO) close(fd);
+    return status;
+}
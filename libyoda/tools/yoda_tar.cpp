@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "yoda_tar.h"
+
+using yoda::Algorithm;
+
+// yoda_tar md5|md6 [-o <manifest>] [archive]
+// Hashes every regular file of a tar archive (standard input without one) in a single read pass.
+// The manifest ("<hex digest>  <path>" per member, as md5sum writes it, so that md5_cpp -c or
+// md6_cpp -c can check the extracted files) goes to standard output or the -o file; the digest of
+// the whole archive and the throughput go to standard error.
+int main(int argc, char** argv) {
+    if (argc < 2 || (std::string(argv[1]) != "md5" && std::string(argv[1]) != "md6")) {
+        std::cerr << "Usage: " << argv[0] << " md5|md6 [-o <manifest>] [archive]\n";
+        return 1;
+    }
+    Algorithm alg = std::string(argv[1]) == "md5" ? Algorithm::MD5 : Algorithm::MD6;
+
+    std::string manifestPath, archivePath;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) manifestPath = argv[++i];
+        else archivePath = arg;
+    }
+
+    int fd = archivePath.empty() || archivePath == "-" ? STDIN_FILENO : open(archivePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open " << archivePath << "\n";
+        return 1;
+    }
+
+    yoda::TarHasher tar(alg);
+    yoda::TarStats stats = yoda::hashTarStream(fd, tar);
+    if (fd != STDIN_FILENO) close(fd);
+
+    std::ofstream file;
+    if (!manifestPath.empty()) {
+        file.open(manifestPath);
+        if (!file) {
+            std::cerr << "Could not write " << manifestPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream& manifest = manifestPath.empty() ? std::cout : file;
+    for (const yoda::TarMember& member : tar.members())
+        if (!member.digest.empty()) manifest << yoda::toHex(member.digest) << "  " << member.name << "\n";
+    manifest.flush();
+
+    fprintf(stderr, "%s  %s\n", yoda::toHex(tar.archiveDigest()).c_str(), archivePath.empty() ? "-" : archivePath.c_str());
+    fprintf(stderr, "%.1f MB, %llu members, %.3f GB/s\n", stats.bytes / 1e6, (unsigned long long) stats.members,
+            stats.seconds > 0 ? stats.bytes / stats.seconds / 1e9 : 0);
+
+    if (!tar.error().empty()) {
+        std::cerr << (stats.ok ? "Archive is damaged: " : "Could not read the archive: ") << tar.error() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "yoda_daemon.h"
+#include "yoda_metrics.h"
+
+using yoda::Algorithm;
+using yoda::Engine;
+
+// A client socket and its outbound queue. Responses are queued by respond(), which never touches the
+// socket, and written by the connection's own writer thread, the only thread that writes to the fd: a
+// client that reads slowly holds up nobody else, and responses cannot interleave. The socket is closed
+// once the reader has finished and the last response has been written.
+class Connection {
+public:
+    const int fd;
+
+    explicit Connection(int fd) : fd(fd), reading(true), broken(false), outstanding(0) {}
+    ~Connection() { close(fd); }
+
+    // Called by the reader before each response it causes, so that the writer waits for it
+    void expectResponse() {
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding++;
+    }
+
+    void respond(const yoda::ResponseHeader& header, const uint8_t* digest, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        outstanding--;
+        if (broken) return;
+
+        // A client that sends requests without reading the responses is dropped rather than buffered
+        if (pending.size() + sizeof(header) + length > maxPendingBytes) {
+            fail();
+        } else {
+            pending.insert(pending.end(), (const uint8_t*) &header, (const uint8_t*) &header + sizeof(header));
+            pending.insert(pending.end(), digest, digest + length);
+        }
+        ready.notify_one();
+    }
+
+    void readerDone() {
+        std::lock_guard<std::mutex> lock(mutex);
+        reading = false;
+        ready.notify_one();
+    }
+
+    void writeResponses() {
+        std::vector<uint8_t> out;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return !pending.empty() || broken || (!reading && outstanding == 0); });
+                if (pending.empty()) return;
+                out.clear();
+                out.swap(pending);
+            }
+            if (!yoda::writeFull(fd, out.data(), out.size())) {
+                std::lock_guard<std::mutex> lock(mutex);
+                fail();
+                return;
+            }
+        }
+    }
+
+private:
+    static const size_t maxPendingBytes = 1 << 20;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<uint8_t> pending;
+    bool reading, broken;
+    size_t outstanding;
+
+    // Holding the mutex. Wakes the reader too, so that both threads let go of the connection.
+    void fail() {
+        broken = true;
+        pending.clear();
+        shutdown(fd, SHUT_RDWR);
+    }
+};
+
+struct Request {
+    std::shared_ptr<Connection> connection;
+    Algorithm alg;
+    std::vector<uint8_t> data;
+    std::chrono::steady_clock::time_point arrived;
+};
+
+static std::mutex queueMutex;
+static std::condition_variable queueReady;
+static std::deque<Request> queue;
+
+static std::atomic<bool> stopping{false};
+static int listenFd = -1;
+
+static void stop(int) {
+    stopping = true;
+    shutdown(listenFd, SHUT_RDWR);  // Wakes accept()
+}
+
+// Reads requests from one client until it disconnects or sends something malformed
+static void serveConnection(std::shared_ptr<Connection> connection) {
+    while (true) {
+        yoda::RequestHeader header{};
+        if (!yoda::readFull(connection->fd, &header, sizeof(header))) break;
+        if (header.algorithm > 1 || header.length > yoda::maxRequestBytes) {
+            yoda::ResponseHeader response{};
+            response.status = 1;
+            connection->expectResponse();
+            connection->respond(response, nullptr, 0);
+            break;
+        }
+
+        Request request;
+        request.connection = connection;
+        request.alg = header.algorithm == 0 ? Algorithm::MD5 : Algorithm::MD6;
+        request.data.resize(header.length);
+        if (!yoda::readFull(connection->fd, request.data.data(), header.length)) break;
+        request.arrived = std::chrono::steady_clock::now();
+
+        connection->expectResponse();
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(request));
+        queueReady.notify_one();
+    }
+    connection->readerDone();
+}
+
+struct BatchStats {
+    uint64_t batches = 0;
+    uint64_t requests = 0;
+    uint64_t largest = 0;
+    uint64_t perEngine[6] = {};
+};
+
+// Collects the requests that arrive within the window after the first one and hashes them as one
+// batch per algorithm. Responses are handed to each connection's queue in request order.
+static void batcher(std::chrono::microseconds window, size_t maxBatch, BatchStats& stats) {
+    while (true) {
+        std::vector<Request> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [] { return !queue.empty() || stopping; });
+            if (queue.empty()) return;
+
+            auto deadline = queue.front().arrived + window;
+            queueReady.wait_until(lock, deadline, [&] { return queue.size() >= maxBatch || stopping; });
+
+            size_t take = std::min(queue.size(), maxBatch);
+            for (size_t i = 0; i < take; i++) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+
+        stats.batches++;
+        stats.requests += batch.size();
+        stats.largest = std::max<uint64_t>(stats.largest, batch.size());
+
+        std::vector<yoda::Digest> digests(batch.size());
+        std::vector<Engine> engines(batch.size());
+        for (Algorithm alg : {Algorithm::MD5, Algorithm::MD6}) {
+            std::vector<size_t> indices;
+            std::vector<const uint8_t*> messages;
+            std::vector<size_t> lengths;
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (batch[i].alg != alg) continue;
+                indices.push_back(i);
+                messages.push_back(batch[i].data.data());
+                lengths.push_back(batch[i].data.size());
+            }
+            if (indices.empty()) continue;
+
+            std::vector<yoda::Digest> result = yoda::hashBatch(alg, messages.data(), lengths.data(), indices.size());
+            Engine engine = yoda::lastEngine();
+            stats.perEngine[(int) engine] += indices.size();
+            for (size_t k = 0; k < indices.size(); k++) {
+                digests[indices[k]] = std::move(result[k]);
+                engines[indices[k]] = engine;
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            yoda::ResponseHeader response{};
+            response.length = (uint8_t) digests[i].size();
+            response.engine = (uint8_t) engines[i];
+            batch[i].connection->respond(response, digests[i].data(), digests[i].size());
+        }
+    }
+}
+
+// Prometheus textfile collector style: the whole file is replaced, never seen half written
+static void writeMetrics(const std::string& path) {
+    std::string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "w");
+    if (file == nullptr) return;
+    std::string text = yoda::metricsText();
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
+    rename(temp.c_str(), path.c_str());
+}
+
+// yodad [socket] [window microseconds] [max batch] [metrics file, rewritten every 10 s]
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : yoda::defaultSocketPath;
+    std::chrono::microseconds window(argc > 2 ? std::stoi(argv[2]) : 200);
+    size_t maxBatch = argc > 3 ? std::stoul(argv[3]) : 1024;
+    std::string metricsPath = argc > 4 ? argv[4] : "";
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    // Pay for engine setup (OpenCL context, kernel build) once, before the first client
+    const yoda::Features& f = yoda::features();
+    yoda::hash(Algorithm::MD6, std::string("warm-up"));
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (listenFd < 0 || bind(listenFd, (sockaddr*) &addr, sizeof(addr)) != 0 || listen(listenFd, 128) != 0) {
+        std::cerr << "Could not listen on " << path << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    std::cout << "yodad on " << path << ", window " << window.count() << " us, batches of up to " << maxBatch
+              << ", OpenCL: " << (f.opencl ? f.device : std::string("no device")) << std::endl;
+
+    BatchStats stats;
+    std::thread batchThread(batcher, window, maxBatch, std::ref(stats));
+    if (!metricsPath.empty()) {
+        std::thread([metricsPath] {
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(10));
+                writeMetrics(metricsPath);
+            }
+        }).detach();
+    }
+
+    while (!stopping) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd);
+        std::thread([connection] { connection->writeResponses(); }).detach();
+        std::thread(serveConnection, connection).detach();
+    }
+
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queueReady.notify_one();
+    }
+    batchThread.join();
+    close(listenFd);
+    unlink(path.c_str());
+    if (!metricsPath.empty()) writeMetrics(metricsPath);
+
+    std::cout << "Served " << stats.requests << " requests in " << stats.batches << " batches (mean "
+              << (stats.batches ? (double) stats.requests / stats.batches : 0) << ", largest " << stats.largest
+              << ")\n";
+    const yoda::Metrics m = yoda::metrics();
+    for (Engine engine : {Engine::Scalar, Engine::SIMD, Engine::Threaded, Engine::OpenCL, Engine::Hybrid}) {
+        if (stats.perEngine[(int) engine] == 0) continue;
+
+        yoda::Histogram latency;
+        for (const auto& alg : m.engines) {
+            for (int i = 0; i < yoda::Histogram::buckets; i++) latency.counts[i] += alg[(int) engine].latency.counts[i];
+        }
+        std::cout << "  " << yoda::engineName(engine) << ": " << stats.perEngine[(int) engine]
+                  << " requests, batch hashing p50 " << latency.quantile(0.5) / 1e3 << " us, p99 "
+                  << latency.quantile(0.99) / 1e3 << " us\n";
+    }
+    return 0;
+}
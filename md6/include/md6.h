@@ -2,6 +2,7 @@
 #define MD6_H_INCLUDED
 
 #include <cinttypes>
+#include <cstddef>
 
 // Define min macro
 #define min(a, b) ((a) < (b) ? (a) : (b))
@@ -22,6 +23,9 @@ typedef uint64_t md6_control_word;
 typedef uint64_t md6_nodeID;
 typedef uint64_t md6_word;
 
+// Compression loop over A[0 .. r*c + n), see md6_select_compression_loop
+typedef void (*md6_compression_loop)(md6_word *A, int r);
+
 typedef struct {
     int d;
     int hashbitlen;
@@ -39,15 +43,30 @@ typedef struct {
     md6_word B[md6_max_stack_height][md6_b];
     unsigned int bits[md6_max_stack_height];
     uint64_t i_for_level[md6_max_stack_height];
+    md6_compression_loop compression_loop;
+    md6_word N_prefix[md6_q + md6_k];
+    md6_control_word V_base;
 } md6_state;
 
 extern int md6_init(md6_state *st, int d);
 extern int md6_full_init(md6_state *st, int d, unsigned char *key, int keylen, int L, int r);
+extern int md6_reset(md6_state *st);
 extern int md6_update(md6_state *st, const unsigned char *data, uint64_t databitlen);
 extern int md6_update_parallel(md6_state *st, const unsigned char *data, uint64_t databitlen);
 extern int md6_final(md6_state *st, unsigned char *hashval);
+extern int md6_final_root(md6_state *st, const md6_word *root, unsigned char *hashval);
+extern void md6_reverse_little_endian(uint64_t *x, int count);
+// A checkpoint holds the whole state, including the key K of a keyed hash in plaintext, so it must be
+// stored with the same care as the key itself
+extern size_t md6_checkpoint_size(const md6_state *st);
+extern int md6_checkpoint_save(const md6_state *st, unsigned char *buf, size_t buflen, size_t *written);
+extern int md6_checkpoint_load(md6_state *st, const unsigned char *buf, size_t buflen);
 extern int md6_standard_compress(md6_word *C, const md6_word *Q, const md6_word *K, int ell, int i, int r, int L, int z,
-                                 int p, int keylen, int d, md6_word *B);
+                                 int p, int keylen, int d, md6_word *B, md6_compression_loop loop = nullptr);
+extern int md6_state_compress(md6_word *C, const md6_state *st, int ell, uint64_t i, int z, int p, const md6_word *B);
+extern md6_control_word md6_make_control_word(int r, int L, int z, int p, int keylen, int d);
+extern void md6_main_compression_loop(md6_word *A, int r);
+extern md6_compression_loop md6_select_compression_loop(int r);
 
 #define MD6_SUCCESS 0
 #define MD6_BADHASHLEN 2
@@ -67,6 +86,9 @@ extern int md6_standard_compress(md6_word *C, const md6_word *Q, const md6_word
 #define MD6_BAD_L 16
 #define MD6_BAD_r 17
 #define MD6_OUT_OF_MEMORY 18
+#define MD6_BAD_INDEX 19
+#define MD6_BAD_CHECKPOINT 20
+#define MD6_WORKER_FAILED 21
 
 #if ((md6_w != 8) && (md6_w != 16) && (md6_w != 32) && (md6_w != 64))
 #error "md6.h Fatal error: md6_w must be one of 8,16,32, or 64."
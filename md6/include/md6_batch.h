@@ -0,0 +1,18 @@
+#ifndef MD6_BATCH_H_INCLUDED
+#define MD6_BATCH_H_INCLUDED
+
+#include <cstddef>
+#include "md6.h"
+
+// Arena of one md6_state per worker thread, allocated once and reused for every message of every batch
+typedef struct {
+    md6_state *states;
+    unsigned int num_threads;
+} md6_batch;
+
+extern int md6_batch_init(md6_batch *batch, unsigned int num_threads);
+extern void md6_batch_free(md6_batch *batch);
+extern int md6_batch_hash(md6_batch *batch, const md6_state *params, const unsigned char *const *messages,
+                          const uint64_t *lengths, size_t count, unsigned char *digests);
+
+#endif
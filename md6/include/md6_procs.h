@@ -0,0 +1,33 @@
+#ifndef MD6_PROCS_H_INCLUDED
+#define MD6_PROCS_H_INCLUDED
+
+#include "md6_tree.h"
+
+// Multi-process leaf hashing. A coordinator hands out ranges of leaves (ell = 1, i_for_level first ..
+// first + count - 1) to worker processes, which read the message from a shared mapping and send the
+// leaf chaining values back. The coordinator then builds the upper levels and the root in an md6_tree
+// index, so the digest is the one md6_final gives for the same parameters.
+// The transport is a pair of bounded rings in shared memory, a local stand-in for a network link: a
+// remote worker would need only these messages, the message bytes and the parameters d, key, L and r.
+
+#define md6_procs_range_leaves 64  // Leaves per task: 32 KiB of message out, 8 KiB of chaining values back
+
+typedef struct {
+    uint64_t first;  // i_for_level of the first leaf
+    uint64_t count;  // Number of leaves, 0 tells the worker to exit
+} md6_leaf_range;
+
+typedef struct {
+    md6_leaf_range range;
+    int err;
+    md6_word C[md6_procs_range_leaves * md6_c];
+} md6_leaf_result;
+
+// data must be readable by forked children, which any mapping made before the call is
+extern int md6_procs_hash(md6_tree *t, const unsigned char *data, uint64_t length, int num_workers,
+                          unsigned char *hashval);
+
+// Map a file shared and read-only and hash it with md6_procs_hash
+extern int md6_procs_hash_file(md6_tree *t, const char *path, int num_workers, unsigned char *hashval);
+
+#endif
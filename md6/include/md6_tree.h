@@ -0,0 +1,42 @@
+#ifndef MD6_TREE_H_INCLUDED
+#define MD6_TREE_H_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include "md6.h"
+
+// Bytes per leaf (one full B block at level 1) and children per inner node
+#define md6_leaf_bytes (md6_b * (md6_w / 8))
+#define md6_tree_fanout (md6_b / md6_c)
+
+// A byte range of the message that changed since it was last hashed
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} md6_range;
+
+// Side index holding the chaining value of every (ell, i_for_level) node of the MD6 tree of a message,
+// so that a modified message only needs the leaf-to-root paths above its changed leaves recomputed.
+// Only pure tree mode is supported: the tree must fit below level L + 1 (the sequential level).
+typedef struct {
+    md6_state st;                                   // Hash parameters and packed compression prefix
+    unsigned char key[md6_k * (md6_w / 8)];         // Key as given to md6_tree_init (for md6_tree_save)
+    uint64_t length;                                // Message length in bytes of the indexed tree
+    int levels;                                     // Number of levels; the root is the single node at this level
+    std::vector<md6_word> C[md6_max_stack_height];  // md6_c words per node, for levels 1 .. levels
+} md6_tree;
+
+extern int md6_tree_init(md6_tree *t, int d, unsigned char *key, int keylen, int L, int r);
+extern int md6_tree_hash(md6_tree *t, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern int md6_tree_digest(md6_tree *t, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern int md6_tree_rehash(md6_tree *t, const unsigned char *data, uint64_t length, const md6_range *dirty,
+                           size_t dirty_count, unsigned char *hashval);
+extern int md6_tree_shape(uint64_t length, uint64_t *count);
+extern int md6_tree_compress_leaf(const md6_state *st, const unsigned char *data, uint64_t length, uint64_t i, int z,
+                                  md6_word *C);
+extern int md6_tree_prepare(md6_tree *t, uint64_t length);
+extern int md6_tree_finish(md6_tree *t, unsigned char *hashval);
+extern int md6_tree_save(const md6_tree *t, const char *path);
+extern int md6_tree_load(md6_tree *t, const char *path);
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef MD6_WORD_H_INCLUDED
+#define MD6_WORD_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// MD6 with the word size as a template parameter instead of the md6_w macro, so that the 8, 16, 32
+// and 64-bit variants can be instantiated side by side. Everything derived from w is a constexpr
+// member of md6_word_params<Word>; this header defines no macros and does not include md6.h.
+// Covers unkeyed hashing in tree mode with the default L = 64 (the tree of any practical message
+// stays below the sequential level), which for w = 64 gives the digests of md6_final.
+//
+// Compressions are done in groups of Lanes independent nodes, one per vector lane: 8 lanes of
+// 32-bit words (or 4 of 64-bit words) fill an AVX2 register.
+
+template<typename Word>
+struct md6_word_params {
+    static constexpr int w = (int) sizeof(Word) * 8;
+    static constexpr int c = 16;
+    static constexpr int b = 64;
+    static constexpr int q = 15;
+    static constexpr int k = 8;
+    static constexpr int u = 64 / w;  // Words of the 64-bit node ID U
+    static constexpr int v = 64 / w;  // Words of the 64-bit control word V
+
+    // The compression input is Q, K, U, V and B, so it grows by the extra words of U and V below w = 64
+    // (89 words for w = 64, 91, 95 and 103 for w = 32, 16 and 8). The feedback tap reaches back over
+    // the whole input, the other taps keep their distances from the newest word.
+    static constexpr int n = q + k + u + v + b;
+    static constexpr int t[5] = {17, 18, 21, 31, 67};
+    static constexpr int L = 64;
+    static constexpr int leaf_bytes = b * w / 8;
+    static constexpr int fanout = b / c;
+
+    // Top w bits of the 64-bit constants: S0, Smask, and Q (the first 15 w bits of sqrt(6))
+    static constexpr Word top(uint64_t x) { return (Word) (x >> (64 - w)); }
+    static constexpr Word S0 = top(0x0123456789abcdefULL);
+    static constexpr Word Smask = top(0x7311c2812425cfa0ULL);
+
+    static constexpr uint64_t Q64[15] = {
+            0x7311c2812425cfa0ULL, 0x6432286434aac8e7ULL, 0xb60450e9ef68b7c1ULL, 0xe8fb23908d9f06f1ULL,
+            0xdd2e76cba691e5bfULL, 0x0cd0d63b2c30bc41ULL, 0x1f8ccf6823058f8aULL, 0x54e5ed5b88e3775dULL,
+            0x4ad12aae0a6d6031ULL, 0x3e7f16bb88222e0dULL, 0x8af8671d3fb50c2cULL, 0x995ad1178bd25c31ULL,
+            0xc878c1dd04c4b633ULL, 0x3b72066c7a1552acULL, 0x0d6f3522631effcbULL
+    };
+
+    static constexpr Word Q(int j) {
+        int bit = j * w;
+        return (Word) (Q64[bit / 64] >> (64 - w - bit % 64));
+    }
+
+    // Right and left shift amounts of the 16 steps of a round, from the MD6 reference for each w
+    static constexpr int shifts[4][2][16] = {
+            {{3, 3, 3, 2, 2, 1, 2, 2, 3, 3, 2, 3, 1, 2, 2, 1},
+             {2, 4, 2, 3, 1, 3, 3, 1, 2, 2, 3, 1, 2, 1, 1, 3}},
+            {{5, 4, 3, 5, 7, 5, 5, 2, 4, 3, 4, 3, 4, 7, 7, 2},
+             {6, 7, 2, 4, 2, 6, 3, 7, 5, 7, 6, 5, 5, 6, 4, 3}},
+            {{5, 3, 6, 5, 4, 6, 7, 3, 5, 6, 5, 5, 4, 6, 7, 5},
+             {4, 7, 7, 9, 13, 8, 4, 14, 7, 4, 8, 11, 5, 8, 2, 11}},
+            {{10, 5, 13, 10, 11, 12, 2, 7, 14, 15, 7, 13, 11, 7, 6, 12},
+             {11, 24, 9, 16, 15, 9, 27, 15, 6, 2, 29, 8, 15, 5, 31, 9}}
+    };
+    static constexpr int size_index = (w == 8) ? 0 : (w == 16) ? 1 : (w == 32) ? 2 : 3;
+    static constexpr int rs(int step) { return shifts[size_index][0][step]; }
+    static constexpr int ls(int step) { return shifts[size_index][1][step]; }
+
+    static_assert(w == 8 || w == 16 || w == 32 || w == 64, "MD6 is defined for words of 8, 16, 32 or 64 bits");
+    static_assert(n == q + k + u + v + b, "The compression input must hold Q, K, U, V and B");
+};
+
+// Word, or Lanes of them side by side in a vector
+template<typename Word, int Lanes>
+struct md6_lanes {
+    typedef Word type __attribute__((vector_size(sizeof(Word) * Lanes)));
+};
+
+template<typename Word>
+struct md6_lanes<Word, 1> {
+    typedef Word type;
+};
+
+// The compression loop over A[0 .. r * c + n), every element holding one word of each lane. A[0 .. n)
+// is the input block as md6_word_level lays it out: Q, K, U, V, then B.
+template<typename Word, typename V>
+static inline __attribute__((always_inline)) void md6_word_compression_loop(V *A, int r) {
+    typedef md6_word_params<Word> P;
+    Word S = P::S0;
+
+    for (int j = 0, i = P::n; j < r; j++, i += P::c) {
+#pragma GCC unroll 16
+        for (int step = 0; step < 16; step++) {
+            V x = A[i + step - P::n] ^ S;
+            x ^= A[i + step - P::t[0]];
+            x ^= (A[i + step - P::t[1]] & A[i + step - P::t[2]]);
+            x ^= (A[i + step - P::t[3]] & A[i + step - P::t[4]]);
+            x ^= (x >> P::rs(step));
+            A[i + step] = x ^ (x << P::ls(step));
+        }
+        S = (Word) ((S << 1) ^ (S >> (P::w - 1)) ^ (S & P::Smask));
+    }
+}
+
+// Big-endian word from bytes, as MD6 reads its input
+template<typename Word>
+static inline Word md6_word_load(const unsigned char *bytes) {
+    Word x = 0;
+    for (size_t j = 0; j < sizeof(Word); j++) x = (Word) ((x << 8) | bytes[j]);
+    return x;
+}
+
+// A 64-bit field (U or V) as u words, most significant first
+template<typename Word>
+static inline void md6_word_split(uint64_t field, Word *out) {
+    constexpr int w = md6_word_params<Word>::w;
+    for (int j = 0; j < 64 / w; j++) out[j] = (Word) (field >> (64 - w * (j + 1)));
+}
+
+// One level of the tree: count nodes, node i compressing block(i, B) (which returns its padding p)
+template<typename Word, int Lanes, typename Block>
+static inline __attribute__((always_inline)) void md6_word_level(int d, int r, int ell, uint64_t count, int z,
+                                                                  Block block, std::vector<Word> &C,
+                                                                  typename md6_lanes<Word, Lanes>::type *A) {
+    typedef md6_word_params<Word> P;
+    typedef typename md6_lanes<Word, Lanes>::type V;
+
+    C.assign(count * P::c, 0);
+    Word header[P::q + P::k + P::u + P::v];
+    Word B[P::b];
+
+    for (uint64_t first = 0; first < count; first += Lanes) {
+        for (int l = 0; l < Lanes; l++) {
+            // Short last group: the spare lanes repeat the last node and are dropped
+            uint64_t i = (first + l < count) ? first + l : count - 1;
+            int p = block(i, B);
+
+            for (int j = 0; j < P::q; j++) header[j] = P::Q(j);
+            for (int j = 0; j < P::k; j++) header[P::q + j] = 0;
+            md6_word_split<Word>(((uint64_t) ell << 56) | i, header + P::q + P::k);
+            uint64_t V_word = ((uint64_t) r << 48) | ((uint64_t) P::L << 40) | ((uint64_t) z << 36) |
+                              ((uint64_t) p << 20) | (uint64_t) d;
+            md6_word_split<Word>(V_word, header + P::q + P::k + P::u);
+
+            if constexpr (Lanes == 1) {
+                for (int j = 0; j < P::n - P::b; j++) A[j] = header[j];
+                for (int j = 0; j < P::b; j++) A[P::n - P::b + j] = B[j];
+            } else {
+                for (int j = 0; j < P::n - P::b; j++) A[j][l] = header[j];
+                for (int j = 0; j < P::b; j++) A[P::n - P::b + j][l] = B[j];
+            }
+        }
+
+        md6_word_compression_loop<Word, V>(A, r);
+
+        for (int l = 0; l < Lanes && first + l < count; l++) {
+            for (int j = 0; j < P::c; j++) {
+                if constexpr (Lanes == 1) C[(first + l) * P::c + j] = A[(r - 1) * P::c + P::n + j];
+                else C[(first + l) * P::c + j] = A[(r - 1) * P::c + P::n + j][l];
+            }
+        }
+    }
+}
+
+// MD6 of length bytes with d-bit output (d a multiple of 8, at most c * w / 2) and r rounds (0 for
+// the default 40 + d / 4). Returns false for parameters outside that range.
+template<typename Word, int Lanes = 1>
+static inline __attribute__((always_inline)) bool md6_word_hash(int d, const unsigned char *data, uint64_t length,
+                                                                unsigned char *hashval, int r = 0) {
+    typedef md6_word_params<Word> P;
+    if (d <= 0 || d % 8 != 0 || d > P::c * P::w / 2 || r < 0 || r > 255) return false;
+    if (r == 0) r = 40 + d / 4;
+
+    uint64_t count = (length == 0) ? 1 : (length + P::leaf_bytes - 1) / P::leaf_bytes;
+    int ell = 1;
+    std::vector<Word> C, children;
+
+    // The working array, as whole vectors. It is kept in a vector of words: functions of
+    // std::vector<V> would pass V by value outside the AVX2 code that calls them.
+    typedef typename md6_lanes<Word, Lanes>::type V;
+    std::vector<Word> storage((r * P::c + P::n + 1) * Lanes);
+    uintptr_t address = (uintptr_t) storage.data();
+    V *A = (V *) ((address + sizeof(V) - 1) / sizeof(V) * sizeof(V));
+
+    // Leaves: message bytes, zero padded
+    md6_word_level<Word, Lanes>(d, r, ell, count, count == 1, [&](uint64_t i, Word *B) {
+        uint64_t start = i * P::leaf_bytes;
+        uint64_t bytes = (length - start < (uint64_t) P::leaf_bytes) ? length - start : P::leaf_bytes;
+        unsigned char block[P::leaf_bytes] = {0};
+        if (bytes > 0) memcpy(block, data + start, bytes);
+        for (int j = 0; j < P::b; j++) B[j] = md6_word_load<Word>(block + j * sizeof(Word));
+        return (int) (P::b * P::w - bytes * 8);
+    }, C, A);
+
+    // Inner nodes: up to fanout chaining values of the level below
+    while (count > 1) {
+        children.swap(C);
+        uint64_t below = count;
+        count = (count + P::fanout - 1) / P::fanout;
+        ell++;
+        md6_word_level<Word, Lanes>(d, r, ell, count, count == 1, [&](uint64_t i, Word *B) {
+            uint64_t first = i * P::fanout;
+            uint64_t used = (below - first < (uint64_t) P::fanout) ? below - first : P::fanout;
+            memset(B, 0, P::b * sizeof(Word));
+            memcpy(B, &children[first * P::c], used * P::c * sizeof(Word));
+            return (int) ((P::b - used * P::c) * P::w);
+        }, C, A);
+    }
+
+    // The digest is the last d bits of the root's chaining value, read big-endian
+    unsigned char root[P::c * sizeof(Word)];
+    for (int j = 0; j < P::c; j++)
+        for (size_t byte = 0; byte < sizeof(Word); byte++)
+            root[j * sizeof(Word) + byte] = (unsigned char) (C[j] >> (8 * (sizeof(Word) - 1 - byte)));
+    memcpy(hashval, root + sizeof(root) - d / 8, d / 8);
+    return true;
+}
+
+// Instantiations compiled in md6_word.cpp. The _avx2 ones run 8 (w = 32) or 4 (w = 64) nodes per
+// compression and must only be called when md6_word_has_avx2() is true.
+extern bool md6_word_hash8(int d, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern bool md6_word_hash16(int d, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern bool md6_word_hash32(int d, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern bool md6_word_hash64(int d, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern bool md6_word_hash32_avx2(int d, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern bool md6_word_hash64_avx2(int d, const unsigned char *data, uint64_t length, unsigned char *hashval);
+extern bool md6_word_has_avx2();
+
+#endif
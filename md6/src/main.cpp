@@ -1,8 +1,21 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <fstream>
+#include <cstring>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include "digest_cache.h"
+#include "manifest_check.h"
 #include "md6.h"
+#include "md6_batch.h"
+#include "md6_procs.h"
+#include "md6_tree.h"
+#include "md6_word.h"
 
 std::string md6Hash(const char *inputS, int hashBitLen, bool is_parallel) {
     // Convert nibble to hex
@@ -213,12 +226,778 @@ void singleTestParallel() {
     std::cout << "" << std::endl;
 }
 
+void runCompressionBenchmark() {
+    std::cout << "Running compression loop benchmark (generic vs specialised)\n";
+
+    int compressions = 200000;
+    int digestSizes[4] = {128, 256, 384, 512};
+    static md6_word A[5000];
+
+    for (int d : digestSizes) {
+        int r = 40 + d / 4;
+        md6_compression_loop loops[2] = {md6_main_compression_loop, md6_select_compression_loop(r)};
+        md6_word output[2][md6_c];
+        double times[2];
+
+        for (int l = 0; l < 2; ++l) {
+            for (int j = 0; j < md6_n; ++j) A[j] = j * 0x9e3779b97f4a7c15ULL;
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < compressions; ++i) {
+                loops[l](A, r);
+                // Feed the last n words back in as the next input
+                memcpy(A, A + r * md6_c, md6_n * sizeof(md6_word));
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+
+            times[l] = diff.count();
+            memcpy(output[l], A, sizeof(output[l]));
+        }
+
+        std::cout << "MD6-" << d << " (r = " << r << "): generic " << times[0] * 1e9 / compressions
+                  << " ns, specialised " << times[1] * 1e9 / compressions << " ns per compression, speedup "
+                  << times[0] / times[1] << "x"
+                  << (memcmp(output[0], output[1], sizeof(output[0])) == 0 ? "" : " (OUTPUT MISMATCH)") << "\n";
+    }
+
+    std::cout << "" << std::endl;
+}
+
+void runKeyedBenchmark() {
+    std::cout << "Running keyed MD6 benchmark (per-compression packing vs cached prefix)\n";
+
+    int messages = 100000;
+    unsigned char key[] = "0123456789abcdef0123456789abcdef";
+    unsigned char message[32] = "short message under a fixed key";
+    unsigned char digest[32];
+
+    md6_state st;
+    md6_full_init(&st, 256, key, 32, md6_default_L, 40 + 256 / 4);
+
+    // Compression only: rebuild N from Q, K, U and V each time vs patch U and V into the cached prefix
+    md6_word B[md6_b] = {0};
+    md6_word C[2][md6_c];
+    double times[2];
+
+    for (int l = 0; l < 2; ++l) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < messages; ++i) {
+            B[0] = i;
+            if (l == 0)
+                md6_standard_compress(C[l], st.N_prefix, st.K, 1, i, st.r, st.L, 1, 3840, st.keylen, st.d, B,
+                                      st.compression_loop);
+            else
+                md6_state_compress(C[l], &st, 1, i, 1, 3840, B);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = end - start;
+        times[l] = diff.count();
+    }
+
+    std::cout << "Compression: rebuilt N " << times[0] * 1e9 / messages << " ns, cached prefix "
+              << times[1] * 1e9 / messages << " ns per compression"
+              << (memcmp(C[0], C[1], sizeof(C[0])) == 0 ? "" : " (OUTPUT MISMATCH)") << "\n";
+
+    // End to end: MD6-256 MAC of many short messages under one key
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < messages; ++i) {
+        message[0] = i;
+        md6_full_init(&st, 256, key, 32, md6_default_L, 40 + 256 / 4);
+        md6_update(&st, message, sizeof(message) * 8);
+        md6_final(&st, digest);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    std::cout << "Keyed MD6-256 of " << sizeof(message) << "-byte messages: " << diff.count() * 1e9 / messages
+              << " ns per message\n";
+
+    std::cout << "" << std::endl;
+}
+
+void runIncrementalTests() {
+    std::cout << "Running incremental MD6 tree re-hash tests\n";
+
+    uint64_t fileSize = 1 << 26; // 64 MiB
+    std::vector<unsigned char> file(fileSize);
+    for (uint64_t i = 0; i < fileSize; ++i) file[i] = (unsigned char) (i * 2654435761u >> 13);
+
+    auto *tree = new md6_tree;
+    md6_tree_init(tree, 256, nullptr, 0, md6_default_L, 40 + 256 / 4);
+
+    unsigned char digest[32], expected[32];
+
+    auto start = std::chrono::high_resolution_clock::now();
+    md6_tree_hash(tree, file.data(), fileSize, digest);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> fullTime = end - start;
+
+    std::cout << "Full hash of " << fileSize << " bytes: " << fullTime.count() << "s\n";
+
+    // Change a region in the middle of the file and re-hash only what it touches
+    uint64_t changeSizes[] = {1, 512, 4096, 65536, 1 << 20, 1 << 24};
+    for (uint64_t changeSize : changeSizes) {
+        md6_range dirty = {fileSize / 3, changeSize};
+        for (uint64_t i = 0; i < changeSize; ++i) file[dirty.offset + i] ^= 0x5a;
+
+        start = std::chrono::high_resolution_clock::now();
+        md6_tree_rehash(tree, file.data(), fileSize, &dirty, 1, digest);
+        end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = end - start;
+
+        auto *st = (md6_state *) malloc(sizeof(md6_state));
+        md6_init(st, 256);
+        md6_update(st, file.data(), fileSize * 8);
+        md6_final(st, expected);
+        free(st);
+
+        std::cout << "Re-hash after changing " << changeSize << " bytes: " << diff.count() << "s ("
+                  << fullTime.count() / diff.count() << "x faster than a full hash)"
+                  << (memcmp(digest, expected, sizeof(digest)) == 0 ? "" : " (DIGEST MISMATCH)") << "\n";
+    }
+
+    // One-shot digests without the index, across the window boundaries of md6_tree_digest
+    uint64_t lengths[] = {0, 1, 512, 513, 1 << 21, (1 << 21) + 1, (1 << 23) + 5 * 512 + 7, fileSize};
+    bool oneShotOk = true;
+    for (uint64_t length : lengths) {
+        auto *st = (md6_state *) malloc(sizeof(md6_state));
+        md6_init(st, 256);
+        md6_update(st, file.data(), length * 8);
+        md6_final(st, expected);
+        free(st);
+
+        oneShotOk &= md6_tree_digest(tree, file.data(), length, digest) == MD6_SUCCESS &&
+                     memcmp(digest, expected, sizeof(digest)) == 0;
+    }
+    start = std::chrono::high_resolution_clock::now();
+    md6_tree_digest(tree, file.data(), fileSize, digest);
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> oneShotTime = end - start;
+    std::cout << "One-shot digest without the index: " << oneShotTime.count() << "s"
+              << (oneShotOk ? "" : " (DIGEST MISMATCH)") << "\n";
+
+    delete tree;
+
+    std::cout << "" << std::endl;
+}
+
+void runCheckpointTests() {
+    std::cout << "Running MD6 checkpoint tests\n";
+
+    uint64_t streamSize = 1 << 28;     // 256 MiB stream
+    uint64_t pieceSize = 1 << 20;      // fed 1 MiB at a time
+    uint64_t checkpointEvery = 1 << 26; // checkpoint every 64 MiB
+    std::vector<unsigned char> piece(pieceSize);
+
+    auto *st = (md6_state *) malloc(sizeof(md6_state));
+    auto *resumed = (md6_state *) malloc(sizeof(md6_state));
+    std::vector<unsigned char> checkpoint;
+    uint64_t checkpointOffset = 0;
+    unsigned char digest[32], resumedDigest[32];
+
+    md6_init(st, 256);
+
+    for (uint64_t offset = 0; offset < streamSize; offset += pieceSize) {
+        if (offset > 0 && offset % checkpointEvery == 0) {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            checkpoint.resize(md6_checkpoint_size(st));
+            size_t written;
+            md6_checkpoint_save(st, checkpoint.data(), checkpoint.size(), &written);
+
+            auto end = std::chrono::high_resolution_clock::now();
+            std::chrono::duration<double> diff = end - start;
+
+            checkpointOffset = offset;
+            std::cout << "Checkpoint at " << offset << " bytes: " << written << " bytes (of "
+                      << sizeof(md6_state) << " for the full state), saved in " << diff.count() * 1e6 << " us\n";
+        }
+
+        for (uint64_t i = 0; i < pieceSize; ++i) piece[i] = (unsigned char) ((offset + i) * 2654435761u >> 13);
+        md6_update(st, piece.data(), pieceSize * 8);
+    }
+    md6_final(st, digest);
+
+    // Resume from the last checkpoint as a restarted job would
+    auto start = std::chrono::high_resolution_clock::now();
+    int err = md6_checkpoint_load(resumed, checkpoint.data(), checkpoint.size());
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    for (uint64_t offset = checkpointOffset; offset < streamSize; offset += pieceSize) {
+        for (uint64_t i = 0; i < pieceSize; ++i) piece[i] = (unsigned char) ((offset + i) * 2654435761u >> 13);
+        md6_update(resumed, piece.data(), pieceSize * 8);
+    }
+    md6_final(resumed, resumedDigest);
+
+    std::cout << "Loaded checkpoint in " << diff.count() * 1e6 << " us; resumed digest "
+              << (err == MD6_SUCCESS && memcmp(digest, resumedDigest, sizeof(digest)) == 0 ? "matches"
+                                                                                            : "DOES NOT MATCH")
+              << " the uninterrupted digest\n";
+
+    // A checkpoint with bytes after it (two saves concatenated, a file not truncated) is refused
+    std::vector<unsigned char> padded(checkpoint);
+    padded.push_back(0);
+    int trailingErr = md6_checkpoint_load(resumed, padded.data(), padded.size());
+    std::cout << "Checkpoint with a trailing byte " << (trailingErr == MD6_BAD_CHECKPOINT ? "is refused" : "IS ACCEPTED")
+              << "\n";
+
+    free(st);
+    free(resumed);
+
+    std::cout << "" << std::endl;
+}
+
+void runBatchTests() {
+    size_t keys = 1 << 20;
+    std::cout << "Running MD6-128 batch tests on " << keys << " short keys\n";
+
+    std::vector<std::string> keyStrings(keys);
+    std::vector<const unsigned char *> messages(keys);
+    std::vector<uint64_t> lengths(keys);
+    for (size_t i = 0; i < keys; ++i) {
+        keyStrings[i] = "user:" + std::to_string(i * 7919) + ":session";
+        messages[i] = (const unsigned char *) keyStrings[i].c_str();
+        lengths[i] = keyStrings[i].size();
+    }
+
+    // One hash at a time through md6Hash (malloc'd state, output and hex buffers)
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string lastHash;
+    for (size_t i = 0; i < keys; ++i) lastHash = md6Hash(keyStrings[i].c_str(), 128, false);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    std::cout << "md6Hash loop: " << diff.count() << "s (" << keys / diff.count() << " hashes/s)\n";
+
+    md6_state params;
+    md6_init(&params, 128);
+    std::vector<unsigned char> digests(keys * 16);
+
+    unsigned int threadCounts[2] = {1, 0};
+    for (unsigned int threads : threadCounts) {
+        md6_batch batch;
+        md6_batch_init(&batch, threads);
+
+        start = std::chrono::high_resolution_clock::now();
+        int err = md6_batch_hash(&batch, &params, messages.data(), lengths.data(), keys, digests.data());
+        end = std::chrono::high_resolution_clock::now();
+        diff = end - start;
+
+        // Compare the last digest with the one from md6Hash
+        char hex[33];
+        for (int j = 0; j < 16; ++j) snprintf(hex + 2 * j, 3, "%02x", digests[(keys - 1) * 16 + j]);
+
+        std::cout << "md6_batch_hash with " << batch.num_threads << " thread(s): " << diff.count() << "s ("
+                  << keys / diff.count() << " hashes/s)"
+                  << (err == MD6_SUCCESS && lastHash == hex ? "" : " (DIGEST MISMATCH)") << "\n";
+
+        md6_batch_free(&batch);
+    }
+
+    // Keyed MD6-256 over messages of up to a few blocks, against a fresh state per message, for the
+    // default tree, a shallow one and the sequential mode
+    std::vector<std::string> blocks(64);
+    std::vector<const unsigned char *> blockMessages(blocks.size());
+    std::vector<uint64_t> blockLengths(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].resize(i * 97);
+        for (size_t j = 0; j < blocks[i].size(); ++j) blocks[i][j] = (char) (i * 31 + j * 7);
+        blockMessages[i] = (const unsigned char *) blocks[i].data();
+        blockLengths[i] = blocks[i].size();
+    }
+    unsigned char key[] = "batch key";
+
+    int levels[3] = {64, 2, 0};
+    for (int L : levels) {
+        md6_state keyed;
+        md6_full_init(&keyed, 256, key, sizeof(key) - 1, L, 40 + 256 / 4);
+        std::vector<unsigned char> batchDigests(blocks.size() * 32);
+
+        md6_batch batch;
+        md6_batch_init(&batch, 0);
+        int err = md6_batch_hash(&batch, &keyed, blockMessages.data(), blockLengths.data(), blocks.size(),
+                                 batchDigests.data());
+        md6_batch_free(&batch);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            md6_state st;
+            unsigned char digest[32];
+            md6_full_init(&st, 256, key, sizeof(key) - 1, L, 40 + 256 / 4);
+            md6_update(&st, blockMessages[i], blockLengths[i] * 8);
+            md6_final(&st, digest);
+            if (memcmp(digest, &batchDigests[i * 32], 32) != 0) mismatches++;
+        }
+
+        std::cout << "md6_batch_hash with L = " << L << ": "
+                  << (err == MD6_SUCCESS && mismatches == 0 ? "digests match"
+                                                            : std::to_string(mismatches) + " DIGEST MISMATCH(ES)")
+                  << "\n";
+    }
+
+    std::cout << "" << std::endl;
+}
+
+void runProcsTests() {
+    std::cout << "Running multi-process MD6 leaf hashing tests\n";
+
+    const std::string path = "md6_procs_test.bin";
+    uint64_t fileSize = 1 << 28; // 256 MiB
+    {
+        std::vector<unsigned char> chunk(1 << 20);
+        std::ofstream out(path, std::ios::binary);
+        for (uint64_t offset = 0; offset < fileSize; offset += chunk.size()) {
+            for (size_t i = 0; i < chunk.size(); ++i) chunk[i] = (unsigned char) ((offset + i) * 2654435761u >> 13);
+            out.write((const char *) chunk.data(), chunk.size());
+        }
+    }
+
+    // md6_final over the same bytes, fed through md6_update
+    unsigned char expected[32], digest[32];
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> buffer(1 << 20);
+        md6_state st;
+        md6_init(&st, 256);
+        auto start = std::chrono::high_resolution_clock::now();
+        while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0)
+            md6_update(&st, (const unsigned char *) buffer.data(), (uint64_t) in.gcount() * 8);
+        md6_final(&st, expected);
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        std::cout << "md6_update: " << diff.count() << "s\n";
+    }
+
+    auto *tree = new md6_tree;
+    for (int workers : {1, 2, 4, 8}) {
+        md6_tree_init(tree, 256, nullptr, 0, md6_default_L, 40 + 256 / 4);
+        auto start = std::chrono::high_resolution_clock::now();
+        int err = md6_procs_hash_file(tree, path.c_str(), workers, digest);
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+
+        std::cout << workers << " worker processes: " << diff.count() << "s"
+                  << (err == MD6_SUCCESS && memcmp(digest, expected, sizeof(digest)) == 0 ? "" : " (DIGEST MISMATCH)")
+                  << "\n";
+    }
+
+    // Lengths around the leaf and task boundaries
+    int failures = 0;
+    for (uint64_t length : {0ull, 1ull, 511ull, 512ull, 513ull, 32767ull, 32768ull, 32769ull, 2097153ull}) {
+        std::vector<unsigned char> data(length);
+        for (uint64_t i = 0; i < length; ++i) data[i] = (unsigned char) (i * 7 + 3);
+
+        md6_state st;
+        md6_init(&st, 256);
+        md6_update(&st, data.data(), length * 8);
+        md6_final(&st, expected);
+
+        md6_tree_init(tree, 256, nullptr, 0, md6_default_L, 40 + 256 / 4);
+        if (md6_procs_hash(tree, data.data(), length, 3, digest) != MD6_SUCCESS ||
+            memcmp(digest, expected, sizeof(digest)) != 0) {
+            std::cout << "Length " << length << ": DIGEST MISMATCH\n";
+            failures++;
+        }
+    }
+    std::cout << (failures == 0 ? "All lengths match md6_final\n" : "");
+
+    delete tree;
+    std::remove(path.c_str());
+    std::cout << "" << std::endl;
+}
+
+void runWordSizeBenchmark() {
+    std::cout << "Running MD6 word size benchmark (d = 256, or c * w / 2 for the smaller words)\n";
+
+    uint64_t size = 1 << 24; // 16 MiB
+    std::vector<unsigned char> data(size);
+    for (uint64_t i = 0; i < size; ++i) data[i] = (unsigned char) (i * 2654435761u >> 13);
+
+    unsigned char expected[32], digest[32];
+    auto *st = new md6_state;
+    md6_init(st, 256);
+    auto start = std::chrono::high_resolution_clock::now();
+    md6_update(st, data.data(), size * 8);
+    md6_final(st, expected);
+    std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+    delete st;
+    std::cout << "md6_update (md6_w = 64): " << size / diff.count() / 1e6 << " MB/s\n";
+
+    typedef bool (*hash_fn)(int, const unsigned char *, uint64_t, unsigned char *);
+    struct {
+        const char *name;
+        hash_fn hash;
+        int d;
+        bool avx2;
+    } variants[] = {
+            {"w = 8", md6_word_hash8, 64, false},
+            {"w = 16", md6_word_hash16, 128, false},
+            {"w = 32", md6_word_hash32, 256, false},
+            {"w = 64", md6_word_hash64, 256, false},
+            {"w = 32, AVX2 x 8", md6_word_hash32_avx2, 256, true},
+            {"w = 64, AVX2 x 4", md6_word_hash64_avx2, 256, true},
+    };
+
+    unsigned char w32[32];
+    for (auto &variant : variants) {
+        if (variant.avx2 && !md6_word_has_avx2()) continue;
+
+        start = std::chrono::high_resolution_clock::now();
+        variant.hash(variant.d, data.data(), size, digest);
+        diff = std::chrono::high_resolution_clock::now() - start;
+
+        // Only w = 64 has reference digests here; the AVX2 w = 32 variant is checked against the scalar one
+        std::string check;
+        if (variant.hash == md6_word_hash64 || variant.hash == md6_word_hash64_avx2)
+            check = memcmp(digest, expected, 32) == 0 ? " (matches md6_final)" : " (DIGEST MISMATCH)";
+        if (variant.hash == md6_word_hash32) memcpy(w32, digest, 32);
+        if (variant.hash == md6_word_hash32_avx2)
+            check = memcmp(digest, w32, 32) == 0 ? " (matches scalar w = 32)" : " (DIGEST MISMATCH)";
+
+        std::cout << variant.name << ": " << size / diff.count() / 1e6 << " MB/s" << check << "\n";
+    }
+
+    std::cout << "" << std::endl;
+}
+
+void runWordSizeTests() {
+    std::cout << "Running MD6 word size tests\n";
+
+    typedef bool (*hash_fn)(int, const unsigned char *, uint64_t, unsigned char *);
+    struct {
+        const char *name;
+        hash_fn hash;
+        hash_fn lanes;  // AVX2 instantiation of the same word size, if there is one
+        int d;
+        uint64_t leafBytes;
+    } sizes[] = {
+            {"w = 8", md6_word_hash8, nullptr, 64, 64},
+            {"w = 16", md6_word_hash16, nullptr, 128, 128},
+            {"w = 32", md6_word_hash32, md6_word_hash32_avx2, 128, 256},
+            {"w = 64", md6_word_hash64, md6_word_hash64_avx2, 128, 512},
+    };
+
+    int failures = 0;
+    for (auto &size : sizes) {
+        // Zero messages of different lengths only differ in the padding count p of V and in the tree shape
+        uint64_t leaf = size.leafBytes;
+        std::vector<uint64_t> lengths = {0, 1, 2, 63, 64, leaf - 1, leaf, leaf + 1, 4 * leaf, 4 * leaf + 1, 17 * leaf};
+        std::sort(lengths.begin(), lengths.end());
+        lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+        std::vector<unsigned char> zeros(17 * leaf + 1, 0);
+        std::vector<std::string> digests;
+
+        for (uint64_t length : lengths) {
+            unsigned char digest[32], lanes[32];
+            size.hash(size.d, zeros.data(), length, digest);
+            std::string hex((const char *) digest, size.d / 8);
+            for (size_t j = 0; j < digests.size(); j++) {
+                if (digests[j] == hex && failures++ < 10)
+                    std::cout << size.name << ": " << lengths[j] << " and " << length << " zero bytes collide\n";
+            }
+            digests.push_back(hex);
+
+            if (size.lanes && md6_word_has_avx2()) {
+                size.lanes(size.d, zeros.data(), length, lanes);
+                if (memcmp(digest, lanes, size.d / 8) != 0 && failures++ < 10)
+                    std::cout << size.name << ": AVX2 lanes differ at " << length << " bytes\n";
+            }
+        }
+
+        // The one word size with reference digests
+        if (size.hash == md6_word_hash64) {
+            for (uint64_t length : lengths) {
+                unsigned char expected[16], digest[16];
+                md6_state st;
+                md6_full_init(&st, size.d, nullptr, 0, md6_default_L, 40 + size.d / 4);
+                md6_update(&st, zeros.data(), length * 8);
+                md6_final(&st, expected);
+                size.hash(size.d, zeros.data(), length, digest);
+                if (memcmp(digest, expected, 16) != 0 && failures++ < 10)
+                    std::cout << size.name << ": differs from md6_final at " << length << " bytes\n";
+            }
+        }
+    }
+    std::cout << (failures == 0 ? "All lengths give distinct digests for every word size\n" : "");
+    std::cout << "" << std::endl;
+}
+
+void runUnalignedIngestTests() {
+    std::cout << "Running MD6 bit-unaligned ingest tests\n";
+
+    // Append n bits of src (from bit 0) to dst at bit pos, one bit at a time, as the reference packing
+    auto packBits = [](const unsigned char *src, uint64_t n, std::vector<unsigned char> &dst, uint64_t pos) {
+        for (uint64_t i = 0; i < n; ++i)
+            if (src[i / 8] & (0x80 >> (i % 8))) dst[(pos + i) / 8] |= (unsigned char) (0x80 >> ((pos + i) % 8));
+    };
+
+    // Messages fed in pieces of random bit lengths, each piece in its own buffer, against the packed message
+    std::mt19937_64 rng(4120);
+    auto *st = new md6_state;
+    unsigned char expected[32], digest[32];
+    int failures = 0;
+    for (int trial = 0; trial < 500; ++trial) {
+        uint64_t total = 0;
+        std::vector<std::vector<unsigned char>> pieces;
+        std::vector<uint64_t> pieceBits;
+        while (total < 20000 && (total == 0 || rng() % 16 != 0)) {
+            uint64_t bits = rng() % 5000;
+            std::vector<unsigned char> piece((bits + 7) / 8 + 1);
+            for (unsigned char &byte : piece) byte = rng();
+            pieces.push_back(piece);
+            pieceBits.push_back(bits);
+            total += bits;
+        }
+
+        std::vector<unsigned char> packed((total + 7) / 8 + 1, 0);
+        uint64_t pos = 0;
+        for (size_t j = 0; j < pieces.size(); ++j) {
+            packBits(pieces[j].data(), pieceBits[j], packed, pos);
+            pos += pieceBits[j];
+        }
+        md6_init(st, 256);
+        md6_update(st, packed.data(), total);
+        md6_final(st, expected);
+
+        md6_init(st, 256);
+        for (size_t j = 0; j < pieces.size(); ++j) md6_update(st, pieces[j].data(), pieceBits[j]);
+        md6_final(st, digest);
+
+        if (memcmp(digest, expected, 32) != 0 && failures++ < 5)
+            std::cout << "Mismatch for " << pieces.size() << " pieces, " << total << " bits\n";
+    }
+    std::cout << (failures == 0 ? "All piecewise digests match\n" : "");
+
+    // One call of more than 2^32 bits, which the bit counters of md6_update must not wrap on, against
+    // the same message fed 256 MiB at a time
+    {
+        std::vector<unsigned char> large((520ULL << 20), 0);
+        for (uint64_t i = 0; i < large.size(); i += 4096) large[i] = (unsigned char) (i >> 12);
+        md6_init(st, 256);
+        md6_update(st, large.data(), (uint64_t) large.size() * 8);
+        md6_final(st, digest);
+        md6_init(st, 256);
+        for (uint64_t offset = 0; offset < large.size(); offset += 256ULL << 20)
+            md6_update(st, large.data() + offset, min((uint64_t) 256 << 20, (uint64_t) large.size() - offset) * 8);
+        md6_final(st, expected);
+        std::cout << (memcmp(digest, expected, 32) == 0 ? "520 MiB in one call matches\n" : "520 MiB in one call differs\n");
+    }
+
+    // Throughput: a 16 MiB stream of 1021-bit records, so that almost every append is bit-unaligned,
+    // against 1024-bit records of the same bytes (byte-aligned, copied with memcpy)
+    const uint64_t recordBytes = 128, records = 1 << 17;
+    std::vector<unsigned char> data(records * recordBytes);
+    for (uint64_t i = 0; i < data.size(); ++i) data[i] = (unsigned char) (i * 2654435761u >> 13);
+
+    for (uint64_t recordBits : {(uint64_t) 1024, (uint64_t) 1021}) {
+        double best = 0;
+        for (int run = 0; run < 3; ++run) {
+            auto start = std::chrono::high_resolution_clock::now();
+            md6_init(st, 256);
+            for (uint64_t j = 0; j < records; ++j) md6_update(st, &data[j * recordBytes], recordBits);
+            md6_final(st, digest);
+            std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+            best = std::max(best, records * recordBits / 8 / diff.count() / 1e6);
+        }
+        std::cout << recordBits << "-bit records: " << best << " MB/s (best of 3)\n";
+    }
+
+    // The byte-order conversion alone, one 64-word block at a time
+    md6_word block[md6_b];
+    memcpy(block, data.data(), sizeof(block));
+    const int blocks = 1 << 22;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int j = 0; j < blocks; ++j) {
+        md6_reverse_little_endian(block, md6_b);
+        __asm__ __volatile__("" : : "r"(block) : "memory");
+    }
+    std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+    std::cout << "md6_reverse_little_endian: " << blocks * sizeof(block) / diff.count() / 1e9 << " GB/s\n";
+
+    delete st;
+    std::cout << "" << std::endl;
+}
+
+// Write compression test vectors for the Verilog testbench, one per line:
+// r, the 89 words of N and the 16 words of C from md6_standard_compress, as 16-digit hex words
+void writeCompressionVectors(const std::string &path, int count) {
+    std::ofstream outputFile(path);
+    std::mt19937_64 rng(4120);
+    const int digestSizes[] = {128, 160, 224, 256, 384, 512};
+
+    outputFile << std::hex << std::setfill('0');
+    for (int i = 0; i < count; ++i) {
+        int d = digestSizes[rng() % 6];
+        int r = (i % 4 == 3) ? 1 + rng() % md6_max_r : 40 + d / 4;  // Mostly the default rounds for d
+        int L = rng() % 65;
+        int ell = 1 + rng() % 32;
+        int z = rng() % 2;
+        int p = rng() % (md6_b * md6_w + 1);
+        int keylen = rng() % (md6_k * (md6_w / 8) + 1);
+        int index = rng() & 0x7fffffff;
+
+        unsigned char key[md6_k * (md6_w / 8)];
+        for (unsigned char &byte : key) byte = rng();
+
+        md6_state st;
+        md6_full_init(&st, d, key, keylen, L, r);
+
+        // N = Q, K, U, V, B as md6_standard_compress packs it
+        md6_word N[md6_n];
+        md6_word *B = N + md6_q + md6_k + md6_u + md6_v;
+        memcpy(N, st.N_prefix, sizeof(st.N_prefix));
+        N[md6_q + md6_k] = ((md6_nodeID) ell << 56) | index;
+        N[md6_q + md6_k + md6_u] = md6_make_control_word(r, L, z, p, keylen, d);
+        for (int j = 0; j < md6_b; ++j) B[j] = rng();
+
+        md6_word C[md6_c];
+        md6_standard_compress(C, st.N_prefix, st.K, ell, index, r, L, z, p, keylen, d, B);
+
+        outputFile << std::setw(16) << (uint64_t) r;
+        for (md6_word word : N) outputFile << std::setw(16) << word;
+        for (md6_word word : C) outputFile << std::setw(16) << word;
+        outputFile << "\n";
+    }
+}
+
+// MD6-256 of an open file, read 1 MiB at a time
+bool md6File(int fd, uint8_t *digest) {
+    std::vector<unsigned char> buffer(1 << 20);
+    md6_state st;
+    md6_init(&st, 256);
+
+    ssize_t n;
+    while ((n = read(fd, buffer.data(), buffer.size())) > 0) {
+        md6_update(&st, buffer.data(), (uint64_t) n * 8);
+    }
+    if (n < 0) return false;
+    return md6_final(&st, digest) == MD6_SUCCESS;
+}
+
+// Print md5sum-style lines of MD6-256 digests, taking the digests of unchanged files from the cache
+int hashFiles(const std::vector<std::string> &paths, const std::string &cachePath) {
+    DigestCache cache;
+    if (!cachePath.empty() && !cache.open(cachePath, "md6-256", 32)) {
+        std::cerr << "Could not open digest cache " << cachePath << "\n";
+        return 1;
+    }
+
+    int status = 0;
+    for (const std::string &path : paths) {
+        uint8_t digest[32];
+        bool hit;
+        if (!hashFileCached(path, cachePath.empty() ? nullptr : &cache, md6File, digest, hit)) {
+            std::cerr << "md6_cpp: " << path << ": cannot read\n";
+            status = 1;
+            continue;
+        }
+
+        for (uint8_t byte : digest) {
+            std::cout << std::hex << std::setw(2) << std::setfill('0') << (int) byte;
+        }
+        std::cout << std::dec << "  " << path << "\n";
+    }
+    return status;
+}
+
+
+int main(int argc, char **argv) {
+    // md6_cpp --vectors <file> <count> writes compression vectors for the Verilog testbench
+    if (argc == 4 && std::string(argv[1]) == "--vectors") {
+        writeCompressionVectors(argv[2], std::stoi(argv[3]));
+        return 0;
+    }
+
+    // md6_cpp --procs <workers> <file>... hashes files with the leaves spread over worker processes
+    if (argc >= 3 && std::string(argv[1]) == "--procs") {
+        int workers = std::stoi(argv[2]);
+        int status = 0;
+        auto *tree = new md6_tree;
+        for (int i = 3; i < argc; ++i) {
+            unsigned char digest[32];
+            md6_tree_init(tree, 256, nullptr, 0, md6_default_L, 40 + 256 / 4);
+            if (md6_procs_hash_file(tree, argv[i], workers, digest) != MD6_SUCCESS) {
+                std::cerr << "md6_cpp: " << argv[i] << ": cannot hash\n";
+                status = 1;
+                continue;
+            }
+            for (unsigned char byte : digest) std::cout << std::hex << std::setw(2) << std::setfill('0') << (int) byte;
+            std::cout << std::dec << "  " << argv[i] << "\n";
+        }
+        delete tree;
+        return status;
+    }
+
+    // md6_cpp [--cache <file>] <file>... hashes files, reusing the cached digests of unchanged ones
+    // md6_cpp -c [--quiet] [--fail-fast] [-j <threads>] [--cache <file>] <manifest> verifies a manifest
+    if (argc >= 2) {
+        std::string cachePath;
+        std::vector<std::string> paths;
+        bool check = false;
+        ManifestOptions options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--cache" && i + 1 < argc) cachePath = argv[++i];
+            else if (arg == "-c" || arg == "--check") check = true;
+            else if (arg == "--quiet") options.quiet = true;
+            else if (arg == "--fail-fast") options.failFast = true;
+            else if (arg == "-j" && i + 1 < argc) options.threads = std::stoi(argv[++i]);
+            else paths.push_back(arg);
+        }
+        if (!check) return hashFiles(paths, cachePath);
+
+        DigestCache cache;
+        if (!cachePath.empty()) {
+            if (!cache.open(cachePath, "md6-256", 32)) {
+                std::cerr << "Could not open digest cache " << cachePath << "\n";
+                return 1;
+            }
+            options.cache = &cache;
+        }
+        size_t failures = 0;
+        for (const std::string &manifest : paths.empty() ? std::vector<std::string>{"-"} : paths) {
+            failures += checkManifest(manifest, 32, md6File, "md6_cpp", options, std::cout);
+        }
+        return failures > 0 ? 1 : 0;
+    }
 
-int main() {
     // Run the tests for both parallel and sequential implementations
     // runTests(true);
     // runTests(false);
 
+    // Compare the generic and specialised compression loops
+    // runCompressionBenchmark();
+
+    // Measure the cached N-block prefix on a keyed workload
+    // runKeyedBenchmark();
+
+    // Re-hash a large file after small changes using the tree index
+    // runIncrementalTests();
+
+    // Checkpoint a long stream and resume from the checkpoint
+    // runCheckpointTests();
+
+    // Hash millions of short keys through the batch API
+    // runBatchTests();
+
+    // Spread the leaves of a large file over worker processes
+    // runProcsTests();
+
+    // Compare the word sizes of the templated MD6, scalar and with AVX2 lanes
+    // runWordSizeBenchmark();
+
+    // Check that every word size separates messages of different lengths
+    // runWordSizeTests();
+
+    // Feed bit-unaligned pieces through md6_update and measure the ingest
+    // runUnalignedIngestTests();
+
     // Run sequential verification tests
     singleTestSequential();
 
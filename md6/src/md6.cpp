@@ -34,59 +34,117 @@ static const md6_word Q[15] = {
         0x0d6f3522631effcbULL
 };
 
-int md6_detect_byte_order() {
-    uint64_t x = 1;
-    auto *cp = reinterpret_cast<unsigned char *>(&x);
-    return (*cp == 1) ? 1 : 2;
+// The widest vector of the target the file is compiled for: 32 bytes with AVX2, 16 otherwise
+#if defined(__AVX2__)
+typedef uint64_t md6_lane_vector __attribute__((vector_size(32)));
+typedef unsigned char md6_byte_vector __attribute__((vector_size(32)));
+#define md6_bswap_indices 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, \
+                          23, 22, 21, 20, 19, 18, 17, 16, 31, 30, 29, 28, 27, 26, 25, 24
+#else
+typedef uint64_t md6_lane_vector __attribute__((vector_size(16)));
+typedef unsigned char md6_byte_vector __attribute__((vector_size(16)));
+#define md6_bswap_indices 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+#endif
+
+// GCC shuffles by a vector of indices, Clang only by constant index arguments
+#if defined(__clang__)
+#define md6_bswap_vector(y) __builtin_shufflevector(y, y, md6_bswap_indices)
+#else
+static const md6_byte_vector md6_bswap_shuffle = {md6_bswap_indices};
+#define md6_bswap_vector(y) __builtin_shuffle(y, md6_bswap_shuffle)
+#endif
+
+// Byte-swap the words in place, as MD6 reads its input big-endian. The byte order is known at compile
+// time. Targets with a byte shuffle (SSSE3 and later) swap a vector of words per shuffle; without one,
+// one bswap per word is the fastest there is.
+void md6_reverse_little_endian(uint64_t *x, int count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    int i = 0;
+#if defined(__SSSE3__)
+    const int lanes = sizeof(md6_byte_vector) / sizeof(uint64_t);
+    for (; i + lanes <= count; i += lanes) {
+        md6_byte_vector y;
+        memcpy(&y, x + i, sizeof(y));
+        y = md6_bswap_vector(y);
+        memcpy(x + i, &y, sizeof(y));
+    }
+#endif
+    for (; i < count; ++i) x[i] = __builtin_bswap64(x[i]);
+#else
+    (void) x;
+    (void) count;
+#endif
 }
 
-void md6_reverse_little_endian(uint64_t *x, int count) {
-    if (md6_detect_byte_order() == 1)
-        for (int i = 0; i < count; ++i) {
-            x[i] = (x[i] << 32) | (x[i] >> 32);
-            x[i] = ((x[i] & 0x0000ffff0000ffffULL) << 16) | ((x[i] & 0xffff0000ffff0000ULL) >> 16);
-            x[i] = ((x[i] & 0x00ff00ff00ff00ffULL) << 8) | ((x[i] & 0xff00ff00ff00ff00ULL) >> 8);
-        }
+// count (at most 8) bits of src starting at bit pos, most significant first, as the low bits of the result
+static inline unsigned int md6_read_bits(const unsigned char *src, uint64_t pos, unsigned int count) {
+    unsigned int offset = pos % 8;
+    unsigned int window = (unsigned int) src[pos / 8] << 8;
+    if (offset + count > 8) window |= src[pos / 8 + 1];
+    return (window >> (16 - offset - count)) & ((1u << count) - 1);
 }
 
-static void append_bits(unsigned char *dest, unsigned int destlen, const unsigned char *src, const unsigned int srclen) {
-    int i;
-    uint16_t accum;
-    unsigned int di, srcbytes, accumlen;
+// Append srclen bits of src, starting at bit srcpos, to dest, which holds destlen bits. Bits are taken
+// most significant first. Once dest is byte-aligned, each output byte is a funnel shift of two
+// neighbouring source bytes: (src[j] << s) | (src[j + 1] >> (8 - s)). That is done on whole words and
+// vectors, with per-byte masks dropping the bits that the wide shifts carry into neighbouring bytes.
+static void append_bits(unsigned char *dest, unsigned int destlen, const unsigned char *src, uint64_t srcpos,
+                        unsigned int srclen) {
     if (srclen == 0) return;
 
-    accum = 0;
-    accumlen = 0;
-    if (destlen % 8 != 0) {
-        accumlen = destlen % 8;
-        accum = dest[destlen / 8];
-        accum = accum >> (8 - accumlen);
+    // Fill up the partial byte at the end of dest
+    unsigned int used = destlen % 8;
+    if (used != 0) {
+        unsigned int count = min(8 - used, srclen);
+        unsigned char *last = dest + destlen / 8;
+        *last = (unsigned char) ((*last & (0xff00 >> used)) | (md6_read_bits(src, srcpos, count) << (8 - used - count)));
+        destlen += count;
+        srcpos += count;
+        srclen -= count;
     }
 
-    di = destlen / 8;
-    srcbytes = (srclen + 7) / 8;
-
-    unsigned int newbits;
-    int numbits;
-    unsigned char bits;
-    for (i = 0; i < srcbytes; i++) {
-        if (i != srcbytes - 1) {
-            accum = (accum << 8) ^ src[i];
-            accumlen += 8;
-        } else {
-            newbits = ((srclen % 8 == 0) ? 8 : (srclen % 8));
-            accum = (accum << newbits) | (src[i] >> (8 - newbits));
-            accumlen += newbits;
+    unsigned char *out = dest + destlen / 8;
+    const unsigned char *in = src + srcpos / 8;
+    unsigned int s = srcpos % 8;
+    unsigned int whole = srclen / 8;
+    unsigned int j = 0;
+
+    if (s == 0) {
+        memcpy(out, in, whole);
+        j = whole;
+    } else {
+        // Every output byte j < whole reads in[j] and in[j + 1], which are both within the source bits
+        const uint64_t high = 0x0101010101010101ULL * ((0xffu << s) & 0xff);
+        const uint64_t low = 0x0101010101010101ULL * (0xffu >> (8 - s));
+
+        for (; j + sizeof(md6_lane_vector) <= whole; j += sizeof(md6_lane_vector)) {
+            md6_lane_vector x, y;
+            memcpy(&x, in + j, sizeof(x));
+            memcpy(&y, in + j + 1, sizeof(y));
+            x = ((x << s) & high) | ((y >> (8 - s)) & low);
+            memcpy(out + j, &x, sizeof(x));
         }
-        while (((i != srcbytes - 1) & (accumlen >= 8)) || ((i == srcbytes - 1) & (accumlen > 0))) {
-            numbits = min(8, accumlen);
-            bits = accum >> (accumlen - numbits);
-            bits = bits << (8 - numbits);
-            bits &= (0xff00 >> numbits);
-            dest[di++] = bits;
-            accumlen -= numbits;
+        for (; j + 8 <= whole; j += 8) {
+            uint64_t x, y;
+            memcpy(&x, in + j, 8);
+            memcpy(&y, in + j + 1, 8);
+            x = ((x << s) & high) | ((y >> (8 - s)) & low);
+            memcpy(out + j, &x, 8);
         }
+        for (; j < whole; j++) out[j] = (unsigned char) ((in[j] << s) | (in[j + 1] >> (8 - s)));
     }
+
+    // Trailing bits, at the top of the last byte
+    unsigned int rest = srclen % 8;
+    if (rest != 0) out[j] = (unsigned char) (md6_read_bits(src, srcpos + 8 * (uint64_t) whole, rest) << (8 - rest));
+}
+
+// Pack the parts of the compression input that are fixed for a state: Q, K and the control word without z and p
+static void md6_pack_prefix(md6_state *st) {
+    memcpy(st->N_prefix, Q, q * sizeof(md6_word));
+    memcpy(st->N_prefix + q, st->K, k * sizeof(md6_word));
+    st->V_base = md6_make_control_word(st->r, st->L, 0, 0, st->keylen, st->d);
+    st->compression_loop = md6_select_compression_loop(st->r);
 }
 
 int md6_full_init(md6_state *st, int d, unsigned char *key, int keylen, int L, int r) {
@@ -107,6 +165,7 @@ int md6_full_init(md6_state *st, int d, unsigned char *key, int keylen, int L, i
 
     st->L = L;
     st->r = r;
+    md6_pack_prefix(st);
     st->initialized = 1;
     st->top = 1;
     if (L == 0) st->bits[1] = c * w;
@@ -118,6 +177,27 @@ int md6_init(md6_state *st, int d) {
     return md6_full_init(st, d, nullptr, 0, md6_default_L, 40 + (d / 4));
 }
 
+// Return a used state to the freshly initialised state for the same d, key, L and r.
+// Only the levels up to top can hold data, so only those are cleared.
+int md6_reset(md6_state *st) {
+    if (st == nullptr) return MD6_NULLSTATE;
+    if (!st->initialized) return MD6_STATENOTINIT;
+
+    for (int ell = 1; ell <= st->top; ell++) {
+        memset(st->B[ell], 0, (st->bits[ell] + 7) / 8);
+        st->bits[ell] = 0;
+        st->i_for_level[ell] = 0;
+    }
+
+    st->bits_processed = 0;
+    st->compression_calls = 0;
+    st->finalized = 0;
+    st->top = 1;
+    if (st->L == 0) st->bits[1] = c * w;
+
+    return MD6_SUCCESS;
+}
+
 static int md6_compress_block(md6_word *C, md6_state *st, int ell, int z) {
     if (!st->initialized) return MD6_STATENOTINIT;
     if (ell < 0 || ell >= md6_max_stack_height - 1) return MD6_STACKUNDERFLOW;
@@ -129,8 +209,7 @@ static int md6_compress_block(md6_word *C, md6_state *st, int ell, int z) {
     }
 
     int p = b * w - st->bits[ell];
-    int err = md6_standard_compress(C, Q, st->K, ell, st->i_for_level[ell], st->r, st->L, z, p, st->keylen, st->d,
-                                    st->B[ell]);
+    int err = md6_state_compress(C, st, ell, st->i_for_level[ell], z, p, st->B[ell]);
     if (err) return err;
 
     st->bits[ell] = 0;
@@ -177,7 +256,7 @@ int md6_update_parallel(md6_state *st, const unsigned char *data, uint64_t datab
     std::vector<std::thread> threads;
     std::vector<md6_state> states(num_threads);
 
-    unsigned int chunk_size = databitlen / num_threads;
+    uint64_t chunk_size = databitlen / num_threads;
 
     // Initialize individual states
     for (unsigned int i = 0; i < num_threads; ++i) {
@@ -186,24 +265,25 @@ int md6_update_parallel(md6_state *st, const unsigned char *data, uint64_t datab
         states[i].r = st->r;
         std::memcpy(states[i].K, st->K, sizeof(st->K));
         states[i].keylen = st->keylen;
+        md6_pack_prefix(&states[i]);
     }
 
     // Define a lambda function to process a chunk of data
-    auto process_chunk = [&](unsigned int thread_id, unsigned int start_bit, unsigned int end_bit) {
-        unsigned int portion_size;
+    auto process_chunk = [&](unsigned int thread_id, uint64_t start_bit, uint64_t end_bit) {
+        uint64_t portion_size;
         unsigned char *dest;
         const unsigned char *src;
         int err;
 
-        for (unsigned int j = start_bit; j < end_bit;) {
-            portion_size = min(end_bit - j, static_cast<unsigned int>(b * w - (states[thread_id].bits[1])));
+        for (uint64_t j = start_bit; j < end_bit;) {
+            portion_size = min(end_bit - j, static_cast<uint64_t>(b * w - (states[thread_id].bits[1])));
             dest = (unsigned char *)states[thread_id].B[1] + states[thread_id].bits[1] / 8;
             src = &(data[j / 8]);
 
             if ((portion_size % 8 == 0) && (states[thread_id].bits[1] % 8 == 0) && (j % 8 == 0)) {
                 std::memcpy(dest, src, portion_size / 8);
             } else {
-                append_bits(dest, states[thread_id].bits[1], src, portion_size);
+                append_bits((unsigned char *) states[thread_id].B[1], states[thread_id].bits[1], data, j, portion_size);
             }
 
             j += portion_size;
@@ -222,8 +302,8 @@ int md6_update_parallel(md6_state *st, const unsigned char *data, uint64_t datab
 
     // Create threads to process each chunk
     for (unsigned int i = 0; i < num_threads; ++i) {
-        unsigned int start_bit = i * chunk_size;
-        unsigned int end_bit = (i == num_threads - 1) ? databitlen : start_bit + chunk_size;
+        uint64_t start_bit = i * chunk_size;
+        uint64_t end_bit = (i == num_threads - 1) ? databitlen : start_bit + chunk_size;
         threads.emplace_back(process_chunk, i, start_bit, end_bit);
     }
 
@@ -260,19 +340,19 @@ int md6_update(md6_state *st, const unsigned char *data, uint64_t databitlen) {
     if (st->initialized == 0) return MD6_STATENOTINIT;
     if (data == nullptr) return MD6_NULLDATA;
 
-    unsigned int portion_size;
+    uint64_t portion_size;
     unsigned char *dest;
     const unsigned char *src;
     int err;
-    for (unsigned int j = 0; j < databitlen;) {
-        portion_size = min(databitlen - j, (unsigned int) (b * w - (st->bits[1])));
+    for (uint64_t j = 0; j < databitlen;) {
+        portion_size = min(databitlen - j, (uint64_t) (b * w - (st->bits[1])));
         dest = (unsigned char *) st->B[1] + st->bits[1] / 8;
         src = &(data[j / 8]);
 
         if ((portion_size % 8 == 0) && (st->bits[1] % 8 == 0) && (j % 8 == 0)) {
             memcpy(dest, src, portion_size / 8);
         } else {
-            append_bits(dest, st->bits[1], src, portion_size);
+            append_bits((unsigned char *) st->B[1], st->bits[1], data, j, portion_size);
         }
 
         j += portion_size;
@@ -328,6 +408,18 @@ int find_first_non_zero_bit(md6_state *st) {
     return 1;
 }
 
+// Turn the root chaining value in st->hashval into the trimmed d-bit digest
+static int md6_final_output(md6_state *st, unsigned char *hashval) {
+    md6_reverse_little_endian((md6_word *) st->hashval, c);
+    trim_hashval(st);
+
+    if (hashval != nullptr) memcpy(hashval, st->hashval, (st->d + 7) / 8);
+    md6_compute_hex_hashval(st);
+
+    st->finalized = 1;
+    return MD6_SUCCESS;
+}
+
 int md6_final(md6_state *st, unsigned char *hashval) {
     if (st == nullptr) return MD6_NULLSTATE;
     if (!st->initialized) return MD6_STATENOTINIT;
@@ -337,12 +429,130 @@ int md6_final(md6_state *st, unsigned char *hashval) {
     int err = md6_process(st, ell, 1);
     if (err) return err;
 
-    md6_reverse_little_endian((md6_word *) st->hashval, c);
-    trim_hashval(st);
+    return md6_final_output(st, hashval);
+}
 
-    if (hashval != nullptr) memcpy(hashval, st->hashval, (st->d + 7) / 8);
-    md6_compute_hex_hashval(st);
+// Produce the digest from a root chaining value that was computed outside of md6_update (e.g. by md6_tree)
+int md6_final_root(md6_state *st, const md6_word *root, unsigned char *hashval) {
+    if (st == nullptr) return MD6_NULLSTATE;
+    if (!st->initialized) return MD6_STATENOTINIT;
+    if (root == nullptr) return MD6_NULL_C;
+
+    memcpy(st->hashval, root, c * (w / 8));
+    return md6_final_output(st, hashval);
+}
+
+static const unsigned char md6_checkpoint_magic[4] = {'M', 'D', '6', 'C'};
+static const uint32_t md6_checkpoint_version = 1;
+
+// Fixed part of a checkpoint: magic, version, d, keylen, L, r, top, K, bits_processed, compression_calls
+static const size_t md6_checkpoint_header_size =
+        sizeof(md6_checkpoint_magic) + sizeof(uint32_t) + 5 * sizeof(int32_t) + k * sizeof(md6_word) +
+        2 * sizeof(uint64_t);
+
+// Size of the checkpoint of a state: the header plus, for each occupied level up to top,
+// its bit count, node index and only the live bytes of B
+size_t md6_checkpoint_size(const md6_state *st) {
+    if (st == nullptr) return 0;
+
+    size_t size = md6_checkpoint_header_size;
+    for (int ell = 1; ell <= st->top; ell++)
+        size += sizeof(uint32_t) + sizeof(uint64_t) + (st->bits[ell] + 7) / 8;
+
+    return size;
+}
+
+// Serialize a state that is still being updated, so that hashing can resume from it after a restart.
+// The format is native-endian, and the key K is written as is.
+int md6_checkpoint_save(const md6_state *st, unsigned char *buf, size_t buflen, size_t *written) {
+    if (st == nullptr) return MD6_NULLSTATE;
+    if (!st->initialized || st->finalized) return MD6_STATENOTINIT;
+    if (buf == nullptr) return MD6_NULLDATA;
+
+    size_t size = md6_checkpoint_size(st);
+    if (buflen < size) return MD6_BAD_CHECKPOINT;
+
+    unsigned char *p = buf;
+    auto put = [&p](const void *src, size_t len) {
+        memcpy(p, src, len);
+        p += len;
+    };
+
+    int32_t params[5] = {st->d, st->keylen, st->L, st->r, st->top};
+    uint32_t bits;
+
+    put(md6_checkpoint_magic, sizeof(md6_checkpoint_magic));
+    put(&md6_checkpoint_version, sizeof(md6_checkpoint_version));
+    put(params, sizeof(params));
+    put(st->K, k * sizeof(md6_word));
+    put(&st->bits_processed, sizeof(st->bits_processed));
+    put(&st->compression_calls, sizeof(st->compression_calls));
+
+    for (int ell = 1; ell <= st->top; ell++) {
+        bits = st->bits[ell];
+        put(&bits, sizeof(bits));
+        put(&st->i_for_level[ell], sizeof(st->i_for_level[ell]));
+        put(st->B[ell], (bits + 7) / 8);
+    }
+
+    if (written != nullptr) *written = size;
+    return MD6_SUCCESS;
+}
+
+// Restore a state written by md6_checkpoint_save; md6_update and md6_final can be called on it afterwards
+int md6_checkpoint_load(md6_state *st, const unsigned char *buf, size_t buflen) {
+    if (st == nullptr) return MD6_NULLSTATE;
+    if (buf == nullptr) return MD6_NULLDATA;
+    if (buflen < md6_checkpoint_header_size) return MD6_BAD_CHECKPOINT;
+
+    const unsigned char *p = buf;
+    const unsigned char *end = buf + buflen;
+    auto get = [&p, end](void *dest, size_t len) {
+        if ((size_t) (end - p) < len) return false;
+        memcpy(dest, p, len);
+        p += len;
+        return true;
+    };
+
+    unsigned char magic[sizeof(md6_checkpoint_magic)];
+    uint32_t version;
+    int32_t params[5];
+
+    get(magic, sizeof(magic));
+    get(&version, sizeof(version));
+    get(params, sizeof(params));
+    if (memcmp(magic, md6_checkpoint_magic, sizeof(magic)) != 0 || version != md6_checkpoint_version)
+        return MD6_BAD_CHECKPOINT;
+
+    int d = params[0], keylen = params[1], L = params[2], r = params[3], top = params[4];
+    if (d < 1 || d > 512 || d > w * c / 2) return MD6_BADHASHLEN;
+    if (keylen < 0 || keylen > k * (w / 8)) return MD6_BADKEYLEN;
+    if (L < 0 || L > 255) return MD6_BAD_L;
+    if (r < 0 || r > 255) return MD6_BAD_r;
+    if (top < 1 || top >= md6_max_stack_height - 1) return MD6_BAD_CHECKPOINT;
+
+    memset(st, 0, sizeof(md6_state));
+    st->d = d;
+    st->keylen = keylen;
+    st->L = L;
+    st->r = r;
+    st->top = top;
+    get(st->K, k * sizeof(md6_word));
+    get(&st->bits_processed, sizeof(st->bits_processed));
+    get(&st->compression_calls, sizeof(st->compression_calls));
+
+    uint32_t bits;
+    for (int ell = 1; ell <= top; ell++) {
+        if (!get(&bits, sizeof(bits)) || bits > b * w ||
+            !get(&st->i_for_level[ell], sizeof(st->i_for_level[ell])) ||
+            !get(st->B[ell], (bits + 7) / 8))
+            return MD6_BAD_CHECKPOINT;
+        st->bits[ell] = bits;
+    }
+    if (p != end) return MD6_BAD_CHECKPOINT;  // A checkpoint is exactly what md6_checkpoint_save wrote
+
+    md6_pack_prefix(st);
+    st->initialized = 1;
 
-    st->finalized = 1;
     return MD6_SUCCESS;
 }
@@ -0,0 +1,85 @@
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "md6_batch.h"
+
+// Messages per thread below which a batch is hashed on the calling thread only
+static const size_t md6_batch_min_per_thread = 64;
+
+int md6_batch_init(md6_batch *batch, unsigned int num_threads) {
+    if (batch == nullptr) return MD6_NULLSTATE;
+
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 1;
+
+    batch->states = (md6_state *) calloc(num_threads, sizeof(md6_state));
+    if (batch->states == nullptr) return MD6_OUT_OF_MEMORY;
+    batch->num_threads = num_threads;
+
+    return MD6_SUCCESS;
+}
+
+void md6_batch_free(md6_batch *batch) {
+    if (batch == nullptr) return;
+
+    free(batch->states);
+    batch->states = nullptr;
+    batch->num_threads = 0;
+}
+
+// Hash count byte-aligned messages (lengths in bytes) with the d, key, L and r of params, which must have
+// been set up by md6_full_init. The raw (d + 7) / 8 byte digests are written back to back into digests.
+int md6_batch_hash(md6_batch *batch, const md6_state *params, const unsigned char *const *messages,
+                   const uint64_t *lengths, size_t count, unsigned char *digests) {
+    if (batch == nullptr || batch->states == nullptr || params == nullptr) return MD6_NULLSTATE;
+    if (!params->initialized) return MD6_STATENOTINIT;
+    if (count > 0 && (messages == nullptr || lengths == nullptr || digests == nullptr)) return MD6_NULLDATA;
+
+    size_t digest_len = (params->d + 7) / 8;
+    unsigned int num_threads = batch->num_threads;
+    if (count < md6_batch_min_per_thread * num_threads)
+        num_threads = (unsigned int) min((size_t) num_threads, count / md6_batch_min_per_thread + 1);
+
+    std::vector<int> errors(num_threads, MD6_SUCCESS);
+
+    // Each worker copies the parameters into its own arena state once, then only resets the levels
+    // each message used
+    auto process_messages = [&](unsigned int thread_id, size_t start, size_t end) {
+        md6_state *st = &batch->states[thread_id];
+        memcpy(st, params, sizeof(md6_state));
+        int err = md6_reset(st);
+
+        for (size_t i = start; i < end && !err; i++) {
+            if (i > start) err = md6_reset(st);
+            if (!err) err = md6_update(st, messages[i], lengths[i] * 8);
+            if (!err) err = md6_final(st, digests + i * digest_len);
+        }
+
+        errors[thread_id] = err;
+    };
+
+    if (num_threads <= 1) {
+        process_messages(0, 0, count);
+    } else {
+        std::vector<std::thread> threads;
+        size_t chunk_size = count / num_threads;
+
+        for (unsigned int i = 0; i < num_threads; ++i) {
+            size_t start = i * chunk_size;
+            size_t end = (i == num_threads - 1) ? count : start + chunk_size;
+            threads.emplace_back(process_messages, i, start, end);
+        }
+
+        for (auto &thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    for (int err : errors)
+        if (err) return err;
+
+    return MD6_SUCCESS;
+}
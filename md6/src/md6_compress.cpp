@@ -1,5 +1,6 @@
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 #include "md6.h"
 
 // Define constants
@@ -12,14 +13,30 @@
 #define k md6_k
 #define q md6_q
 
-int RL[16][2] = {
+// Right/left shift amounts for each of the 16 steps of a round
+static constexpr int RL[16][2] = {
         {10, 11}, {5, 24}, {13, 9}, {10, 16}, {11, 15}, {12, 9},
         {2, 27}, {7, 15}, {14, 6}, {15, 2}, {7, 29}, {13, 8},
         {11, 15}, {7, 5}, {6, 31}, {12, 9}
 };
 
-// Main compression loop
-static void md6_main_compression_loop(md6_word *A, int r) {
+// Round constant S for every round up to md6_max_r, computed at compile time
+struct md6_round_constants {
+    md6_word S[md6_max_r];
+
+    constexpr md6_round_constants() : S() {
+        md6_word s = 0x0123456789abcdefULL;
+        for (int j = 0; j < md6_max_r; j++) {
+            S[j] = s;
+            s = (s << 1) ^ (s >> (w - 1)) ^ (s & 0x7311c2812425cfa0ULL);
+        }
+    }
+};
+
+static constexpr md6_round_constants md6_S;
+
+// Main compression loop (generic, any number of rounds)
+void md6_main_compression_loop(md6_word *A, int r) {
     md6_word x, S = 0x0123456789abcdefULL;
     int i = n;
 
@@ -38,8 +55,49 @@ static void md6_main_compression_loop(md6_word *A, int r) {
     }
 }
 
+// One step of a round, with the shift amounts as immediates
+template<int step>
+static inline void md6_step(md6_word *A, int i, md6_word S) {
+    md6_word x = S;
+    x ^= A[i + step - 89];
+    x ^= A[i + step - 17];
+    x ^= (A[i + step - 18] & A[i + step - 21]);
+    x ^= (A[i + step - 31] & A[i + step - 67]);
+    x ^= (x >> RL[step][0]);
+    A[i + step] = x ^ (x << RL[step][1]);
+}
+
+// Fully unrolled round; no step reads a word written in the same round (smallest tap is 17)
+template<int... steps>
+static inline void md6_round(md6_word *A, int i, md6_word S, std::integer_sequence<int, steps...>) {
+    (md6_step<steps>(A, i, S), ...);
+}
+
+// Main compression loop specialised for a fixed number of rounds
+template<int r>
+static void md6_main_compression_loop_fixed(md6_word *A, int) {
+    int i = n;
+
+    for (int j = 0; j < r; j++) {
+        md6_round(A, i, md6_S.S[j], std::make_integer_sequence<int, c>{});
+        i += c;
+    }
+}
+
+// Pick the compression loop for r rounds: the default round counts of
+// MD6-128/256/384/512 (r = 40 + d/4) get a specialised kernel
+md6_compression_loop md6_select_compression_loop(int r) {
+    switch (r) {
+        case 40 + 128 / 4: return md6_main_compression_loop_fixed<40 + 128 / 4>;
+        case 40 + 256 / 4: return md6_main_compression_loop_fixed<40 + 256 / 4>;
+        case 40 + 384 / 4: return md6_main_compression_loop_fixed<40 + 384 / 4>;
+        case 40 + 512 / 4: return md6_main_compression_loop_fixed<40 + 512 / 4>;
+        default: return md6_main_compression_loop;
+    }
+}
+
 // Compression function
-static int md6_compress(md6_word *C, md6_word *N, int r, md6_word *A) {
+static int md6_compress(md6_word *C, md6_word *N, int r, md6_word *A, md6_compression_loop loop) {
     if (!N || !C || r < 0 || r > md6_max_r) return MD6_BAD_r;
 
     md6_word *A_as_given = A;
@@ -49,7 +107,7 @@ static int md6_compress(md6_word *C, md6_word *N, int r, md6_word *A) {
     }
 
     memcpy(A, N, n * sizeof(md6_word));
-    md6_main_compression_loop(A, r);
+    loop(A, r);
     memcpy(C, A + (r - 1) * c + n, c * sizeof(md6_word));
 
     if (!A_as_given) {
@@ -61,7 +119,7 @@ static int md6_compress(md6_word *C, md6_word *N, int r, md6_word *A) {
 }
 
 // Create control word
-static md6_control_word md6_make_control_word(int r, int L, int z, int p, int keylen, int d) {
+md6_control_word md6_make_control_word(int r, int L, int z, int p, int keylen, int d) {
     return (((md6_control_word) 0 << 60) |
             ((md6_control_word) r << 48) |
             ((md6_control_word) L << 40) |
@@ -73,7 +131,7 @@ static md6_control_word md6_make_control_word(int r, int L, int z, int p, int ke
 
 // Standard compress function
 int md6_standard_compress(md6_word *C, const md6_word *Q, const md6_word *K, int ell, int i, int r, int L, int z,
-                                 int p, int keylen, int d, md6_word *B) {
+                                 int p, int keylen, int d, md6_word *B, md6_compression_loop loop) {
     if (!C || !B || !K || !Q) return MD6_NULL_C;
     if (r < 0 || r > md6_max_r || L < 0 || L > 255 || ell < 0 || ell > 255
         || p < 0 || p > b * w || d <= 0 || d > c * w / 2)
@@ -98,5 +156,34 @@ int md6_standard_compress(md6_word *C, const md6_word *Q, const md6_word *K, int
 
     memcpy(N + ni, B, b * sizeof(md6_word));
 
-    return md6_compress(C, N, r, A);
+    if (!loop) loop = md6_select_compression_loop(r);
+    return md6_compress(C, N, r, A, loop);
+}
+
+// Compress B for node (ell, i) of a state, using the Q/K prefix and control word packed at md6_full_init.
+// Only U, the z and p fields of V, and B change between compressions, so they are written straight into A.
+int md6_state_compress(md6_word *C, const md6_state *st, int ell, uint64_t i, int z, int p, const md6_word *B) {
+    if (!C || !B || !st) return MD6_NULL_C;
+    if (ell < 0 || ell > 255 || p < 0 || p > b * w) return MD6_BAD_r;
+
+    md6_word A[5000];
+
+    // Pack
+    int ni = q + k;
+    memcpy(A, st->N_prefix, ni * sizeof(md6_word));
+
+    md6_nodeID U = ((md6_nodeID) ell << 56) | i;
+    memcpy((unsigned char *) &A[ni], &U, min(u * (w / 8), sizeof(md6_nodeID)));
+    ni += u;
+
+    md6_control_word V = st->V_base | ((md6_control_word) z << 36) | ((md6_control_word) p << 20);
+    memcpy((unsigned char *) &A[ni], &V, min(v * (w / 8), sizeof(md6_control_word)));
+    ni += v;
+
+    memcpy(A + ni, B, b * sizeof(md6_word));
+
+    st->compression_loop(A, st->r);
+    memcpy(C, A + (st->r - 1) * c + n, c * sizeof(md6_word));
+
+    return MD6_SUCCESS;
 }
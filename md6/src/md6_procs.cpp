@@ -0,0 +1,238 @@
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "md6_procs.h"
+
+#define c md6_c
+
+#define md6_task_slots 64
+#define md6_result_slots 16
+#define md6_ring_spins 1024
+
+// Bounded multi-producer multi-consumer ring in shared memory. Slots carry sequence numbers
+// (Vyukov's queue) so that producers and consumers never share a lock, and process-shared
+// semaphores count the items and spaces so that an empty or full ring sleeps instead of spinning.
+template<typename T, size_t N>
+struct md6_ring {
+    sem_t items;
+    sem_t spaces;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    struct {
+        std::atomic<uint64_t> seq;
+        T value;
+    } slots[N];
+};
+
+template<typename T, size_t N>
+static void md6_ring_init(md6_ring<T, N> *ring) {
+    sem_init(&ring->items, 1, 0);
+    sem_init(&ring->spaces, 1, N);
+    ring->head.store(0);
+    ring->tail.store(0);
+    for (size_t i = 0; i < N; i++) ring->slots[i].seq.store(i);
+}
+
+template<typename T, size_t N>
+static void md6_ring_destroy(md6_ring<T, N> *ring) {
+    sem_destroy(&ring->items);
+    sem_destroy(&ring->spaces);
+}
+
+// Called once a space has been reserved
+template<typename T, size_t N>
+static void md6_ring_put(md6_ring<T, N> *ring, const T &value) {
+    uint64_t pos = ring->tail.fetch_add(1);
+    auto &slot = ring->slots[pos % N];
+    while (slot.seq.load(std::memory_order_acquire) != pos) sched_yield();  // The last lap's reader is copying out
+    slot.value = value;
+    slot.seq.store(pos + 1, std::memory_order_release);
+    sem_post(&ring->items);
+}
+
+// Called once an item has been reserved. The item counted may be a later slot than this one, whose
+// writer is still copying in; lost() is asked every md6_ring_spins yields whether that writer died,
+// and then the take fails.
+template<typename T, size_t N, typename Lost>
+static bool md6_ring_take(md6_ring<T, N> *ring, T &value, Lost lost) {
+    uint64_t pos = ring->head.fetch_add(1);
+    auto &slot = ring->slots[pos % N];
+    for (unsigned spins = 1; slot.seq.load(std::memory_order_acquire) != pos + 1; spins++) {
+        if (spins % md6_ring_spins == 0 && lost()) return false;
+        sched_yield();
+    }
+    value = slot.value;
+    slot.seq.store(pos + N, std::memory_order_release);
+    sem_post(&ring->spaces);
+    return true;
+}
+
+static bool md6_sem_wait(sem_t *sem) {
+    while (sem_wait(sem) != 0)
+        if (errno != EINTR) return false;
+    return true;
+}
+
+typedef struct {
+    md6_ring<md6_leaf_range, md6_task_slots> tasks;
+    md6_ring<md6_leaf_result, md6_result_slots> results;
+} md6_procs_shared;
+
+static void md6_procs_worker(md6_procs_shared *shared, const md6_state *st, const unsigned char *data,
+                             uint64_t length) {
+    md6_leaf_result result;
+
+    for (;;) {
+        if (!md6_sem_wait(&shared->tasks.items)) _exit(1);
+        md6_ring_take(&shared->tasks, result.range, [] { return false; });  // Only the coordinator writes
+        if (result.range.count == 0) _exit(0);
+
+        result.err = MD6_SUCCESS;
+        for (uint64_t j = 0; j < result.range.count && result.err == MD6_SUCCESS; j++)
+            result.err = md6_tree_compress_leaf(st, data, length, result.range.first + j, 0, &result.C[j * c]);
+
+        if (!md6_sem_wait(&shared->results.spaces)) _exit(1);
+        md6_ring_put(&shared->results, result);
+    }
+}
+
+// A worker that died without being told to exit, for a coordinator that has waited a while for results
+static bool md6_procs_lost_worker(std::vector<pid_t> &pids) {
+    for (pid_t &pid : pids) {
+        if (pid > 0 && waitpid(pid, nullptr, WNOHANG) == pid) {
+            pid = -1;
+            return true;
+        }
+    }
+    return false;
+}
+
+int md6_procs_hash(md6_tree *t, const unsigned char *data, uint64_t length, int num_workers,
+                   unsigned char *hashval) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (data == nullptr && length > 0) return MD6_NULLDATA;
+
+    uint64_t count[md6_max_stack_height] = {0};
+    md6_tree_shape(length, count);
+    uint64_t leaves = count[1];
+
+    // A single leaf is the root (z = 1), too little to hand out
+    if (num_workers < 1 || leaves < 2) return md6_tree_hash(t, data, length, hashval);
+
+    int err = md6_tree_prepare(t, length);
+    if (err) return err;
+
+    void *mapping = mmap(nullptr, sizeof(md6_procs_shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) return MD6_OUT_OF_MEMORY;
+    auto *shared = new (mapping) md6_procs_shared;
+    md6_ring_init(&shared->tasks);
+    md6_ring_init(&shared->results);
+
+    std::vector<pid_t> pids;
+    for (int k = 0; k < num_workers; k++) {
+        pid_t pid = fork();
+        if (pid == 0) md6_procs_worker(shared, &t->st, data, length);
+        if (pid > 0) pids.push_back(pid);
+    }
+
+    uint64_t tasks = (leaves + md6_procs_range_leaves - 1) / md6_procs_range_leaves;
+    uint64_t sent = 0, received = 0;
+    md6_leaf_result result;
+    err = pids.empty() ? MD6_WORKER_FAILED : MD6_SUCCESS;
+
+    while (err == MD6_SUCCESS && received < tasks) {
+        // Keep the task ring full, then collect whatever has come back
+        while (sent < tasks && sem_trywait(&shared->tasks.spaces) == 0) {
+            md6_leaf_range range = {sent * md6_procs_range_leaves,
+                                    min(leaves - sent * md6_procs_range_leaves, (uint64_t) md6_procs_range_leaves)};
+            md6_ring_put(&shared->tasks, range);
+            sent++;
+        }
+
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 100000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        if (sem_timedwait(&shared->results.items, &deadline) != 0) {
+            if (errno == ETIMEDOUT && md6_procs_lost_worker(pids)) err = MD6_WORKER_FAILED;
+            continue;
+        }
+
+        if (!md6_ring_take(&shared->results, result, [&] { return md6_procs_lost_worker(pids); })) {
+            err = MD6_WORKER_FAILED;
+            continue;
+        }
+        if (result.err) err = result.err;
+        memcpy(&t->C[1][result.range.first * c], result.C, result.range.count * c * sizeof(md6_word));
+        received++;
+    }
+
+    // Tell the workers to exit; after a failure they are killed, as some may be stuck on a full ring
+    for (pid_t pid : pids) {
+        if (pid <= 0) continue;
+        if (err == MD6_SUCCESS) {
+            md6_leaf_range stop = {0, 0};
+            md6_sem_wait(&shared->tasks.spaces);
+            md6_ring_put(&shared->tasks, stop);
+        } else {
+            kill(pid, SIGKILL);
+        }
+    }
+    for (pid_t pid : pids) {
+        int status = 0;
+        if (pid > 0 && waitpid(pid, &status, 0) == pid && err == MD6_SUCCESS &&
+            !(WIFEXITED(status) && WEXITSTATUS(status) == 0))
+            err = MD6_WORKER_FAILED;
+    }
+
+    md6_ring_destroy(&shared->tasks);
+    md6_ring_destroy(&shared->results);
+    shared->~md6_procs_shared();
+    munmap(mapping, sizeof(md6_procs_shared));
+
+    if (err) {
+        t->levels = 0;
+        return err;
+    }
+    return md6_tree_finish(t, hashval);
+}
+
+int md6_procs_hash_file(md6_tree *t, const char *path, int num_workers, unsigned char *hashval) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return MD6_NULLDATA;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return MD6_NULLDATA;
+    }
+
+    uint64_t length = (uint64_t) st.st_size;
+    void *data = nullptr;
+    if (length > 0) {
+        data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return MD6_OUT_OF_MEMORY;
+        }
+    }
+    close(fd);
+
+    int err = md6_procs_hash(t, (const unsigned char *) data, length, num_workers, hashval);
+    if (data) munmap(data, length);
+    return err;
+}
@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "md6_tree.h"
+
+#define w md6_w
+#define c md6_c
+#define b md6_b
+
+static const char md6_tree_magic[4] = {'M', 'D', '6', 'T'};
+static const uint32_t md6_tree_version = 1;
+
+// Number of nodes on each level of the tree for a message of length bytes; returns the number of levels
+int md6_tree_shape(uint64_t length, uint64_t *count) {
+    int levels = 1;
+    count[1] = (length == 0) ? 1 : (length + md6_leaf_bytes - 1) / md6_leaf_bytes;
+
+    while (count[levels] > 1 && levels < md6_max_stack_height - 2) {
+        count[levels + 1] = (count[levels] + md6_tree_fanout - 1) / md6_tree_fanout;
+        levels++;
+    }
+
+    return levels;
+}
+
+// Compress inner node (ell, i) from the chaining values of its children (1 .. md6_tree_fanout of them)
+static int md6_tree_compress_parent(const md6_state *st, int ell, uint64_t i, int z, const md6_word *children,
+                                    uint64_t n, md6_word *C) {
+    md6_word B[b];
+    memset(B, 0, sizeof(B));
+    memcpy(B, children, n * c * sizeof(md6_word));
+    int p = b * w - (int) (n * c * w);
+
+    return md6_state_compress(C, st, ell, i, z, p, B);
+}
+
+// Recompute the chaining value of node (ell, i) from the message (leaves) or its children (inner nodes)
+static int md6_tree_compress_node(md6_tree *t, const unsigned char *data, int ell, uint64_t i,
+                                  const uint64_t *count) {
+    int z = (ell == t->levels) ? 1 : 0;
+    if (ell == 1) return md6_tree_compress_leaf(&t->st, data, t->length, i, z, &t->C[1][i * c]);
+
+    uint64_t first = i * md6_tree_fanout;
+    uint64_t children = min(count[ell - 1] - first, (uint64_t) md6_tree_fanout);
+    return md6_tree_compress_parent(&t->st, ell, i, z, &t->C[ell - 1][first * c], children, &t->C[ell][i * c]);
+}
+
+// Compress leaf i of a message of length bytes into C (md6_c words); z is 1 only for a single-leaf message
+int md6_tree_compress_leaf(const md6_state *st, const unsigned char *data, uint64_t length, uint64_t i, int z,
+                           md6_word *C) {
+    md6_word B[b];
+    memset(B, 0, sizeof(B));
+
+    uint64_t start = i * md6_leaf_bytes;
+    uint64_t bytes = min(length - start, (uint64_t) md6_leaf_bytes);
+    if (bytes > 0) memcpy(B, data + start, bytes);
+    md6_reverse_little_endian(B, b);
+    int p = b * w - (int) (bytes * 8);
+
+    return md6_state_compress(C, st, 1, i, z, p, B);
+}
+
+// Run compress(j) for j = 0 .. n - 1, spread over threads when there are enough of them; the first error wins
+template <typename Compress>
+static int md6_tree_parallel(size_t n, const Compress &compress) {
+    unsigned int num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0 || n < 4 * (size_t) num_threads) num_threads = 1;
+
+    std::vector<int> errors(num_threads, MD6_SUCCESS);
+
+    auto process_nodes = [&](unsigned int thread_id, size_t start, size_t end) {
+        for (size_t j = start; j < end && errors[thread_id] == MD6_SUCCESS; j++)
+            errors[thread_id] = compress(j);
+    };
+
+    if (num_threads == 1) {
+        process_nodes(0, 0, n);
+    } else {
+        std::vector<std::thread> threads;
+        size_t chunk_size = n / num_threads;
+
+        for (unsigned int i = 0; i < num_threads; ++i) {
+            size_t start = i * chunk_size;
+            size_t end = (i == num_threads - 1) ? n : start + chunk_size;
+            threads.emplace_back(process_nodes, i, start, end);
+        }
+
+        for (auto &thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    for (int err : errors)
+        if (err) return err;
+
+    return MD6_SUCCESS;
+}
+
+// Recompute the given nodes of one level
+static int md6_tree_compress_level(md6_tree *t, const unsigned char *data, int ell,
+                                   const std::vector<uint64_t> &nodes, const uint64_t *count) {
+    return md6_tree_parallel(nodes.size(),
+                             [&](size_t j) { return md6_tree_compress_node(t, data, ell, nodes[j], count); });
+}
+
+int md6_tree_init(md6_tree *t, int d, unsigned char *key, int keylen, int L, int r) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (L < 1) return MD6_BAD_L;
+
+    int err = md6_full_init(&t->st, d, key, keylen, L, r);
+    if (err) return err;
+
+    memset(t->key, 0, sizeof(t->key));
+    if (key && keylen > 0) memcpy(t->key, key, keylen);
+
+    t->length = 0;
+    t->levels = 0;
+    for (auto &level : t->C) level.clear();
+
+    return MD6_SUCCESS;
+}
+
+// Hash a whole message and index every node of its tree
+int md6_tree_hash(md6_tree *t, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    if (t == nullptr) return MD6_NULLSTATE;
+
+    t->levels = 0;
+    return md6_tree_rehash(t, data, length, nullptr, 0, hashval);
+}
+
+// Hash a whole message without indexing it. The leaves go through in windows of the subtree under one
+// node of level md6_tree_window_levels + 1 (2 MiB of message), each reduced to that node before the next
+// window, so only one window of chaining values and the window roots are held.
+#define md6_tree_window_levels 6
+
+int md6_tree_digest(md6_tree *t, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (!t->st.initialized) return MD6_STATENOTINIT;
+    if (data == nullptr && length > 0) return MD6_NULLDATA;
+
+    uint64_t count[md6_max_stack_height] = {0};
+    int levels = md6_tree_shape(length, count);
+    if (count[levels] != 1 || levels > t->st.L) return MD6_BAD_L;
+
+    int top = min(levels, md6_tree_window_levels + 1);
+    uint64_t window = 1;
+    for (int ell = 1; ell < top; ell++) window *= md6_tree_fanout;
+
+    const md6_state *st = &t->st;
+    std::vector<md6_word> roots(count[top] * c), level, parents;
+
+    for (uint64_t k = 0; k < count[top]; k++) {
+        uint64_t first = k * window;
+        uint64_t n = min(count[1] - first, window);
+        level.resize(n * c);
+        int err = md6_tree_parallel(n, [&](size_t j) {
+            return md6_tree_compress_leaf(st, data, length, first + j, (levels == 1) ? 1 : 0, &level[j * c]);
+        });
+        if (err) return err;
+
+        // Up to the root of the window, node numbers offset by the window's first node on each level
+        for (int ell = 2; ell <= top; ell++) {
+            first /= md6_tree_fanout;
+            uint64_t m = (n + md6_tree_fanout - 1) / md6_tree_fanout;
+            parents.resize(m * c);
+            err = md6_tree_parallel(m, [&](size_t j) {
+                uint64_t children = min(n - j * md6_tree_fanout, (uint64_t) md6_tree_fanout);
+                return md6_tree_compress_parent(st, ell, first + j, (ell == levels) ? 1 : 0,
+                                                &level[j * md6_tree_fanout * c], children, &parents[j * c]);
+            });
+            if (err) return err;
+            level.swap(parents);
+            n = m;
+        }
+        memcpy(&roots[k * c], level.data(), c * sizeof(md6_word));
+    }
+
+    // The levels above the windows, one chaining value per 2 MiB of message below them
+    for (int ell = top + 1; ell <= levels; ell++) {
+        parents.resize(count[ell] * c);
+        int err = md6_tree_parallel(count[ell], [&](size_t j) {
+            uint64_t children = min(count[ell - 1] - j * md6_tree_fanout, (uint64_t) md6_tree_fanout);
+            return md6_tree_compress_parent(st, ell, j, (ell == levels) ? 1 : 0, &roots[j * md6_tree_fanout * c],
+                                            children, &parents[j * c]);
+        });
+        if (err) return err;
+        roots.swap(parents);
+    }
+
+    return md6_final_root(&t->st, roots.data(), hashval);
+}
+
+// Re-hash a message whose indexed version differs only in the dirty ranges (and possibly its length).
+// Only the leaves overlapping a dirty range and their ancestors are recomputed.
+int md6_tree_rehash(md6_tree *t, const unsigned char *data, uint64_t length, const md6_range *dirty,
+                    size_t dirty_count, unsigned char *hashval) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (!t->st.initialized) return MD6_STATENOTINIT;
+    if ((data == nullptr && length > 0) || (dirty == nullptr && dirty_count > 0)) return MD6_NULLDATA;
+
+    uint64_t count[md6_max_stack_height] = {0};
+    int levels = md6_tree_shape(length, count);
+    if (count[levels] != 1 || levels > t->st.L) return MD6_BAD_L;
+
+    std::vector<uint64_t> nodes;
+    auto mark_leaves = [&](uint64_t first, uint64_t last) {
+        last = min(last, count[1] - 1);
+        for (uint64_t i = first; i <= last; i++) nodes.push_back(i);
+    };
+
+    if (t->levels == 0) {
+        // Nothing indexed yet
+        mark_leaves(0, count[1] - 1);
+    } else {
+        for (size_t j = 0; j < dirty_count; j++)
+            if (dirty[j].length > 0)
+                mark_leaves(dirty[j].offset / md6_leaf_bytes,
+                            (dirty[j].offset + dirty[j].length - 1) / md6_leaf_bytes);
+
+        // A length change alters the padding of the old last leaf and the shape of the tree after it
+        if (length != t->length) {
+            uint64_t common = min(length, t->length);
+            mark_leaves((common == 0) ? 0 : (common - 1) / md6_leaf_bytes, count[1] - 1);
+        }
+
+        std::sort(nodes.begin(), nodes.end());
+        nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    }
+
+    t->length = length;
+    t->levels = levels;
+    for (int ell = 1; ell < md6_max_stack_height; ell++)
+        t->C[ell].resize((ell <= levels) ? count[ell] * c : 0);
+
+    for (int ell = 1; ell <= levels && !nodes.empty(); ell++) {
+        int err = md6_tree_compress_level(t, data, ell, nodes, count);
+        if (err) {
+            t->levels = 0;
+            return err;
+        }
+
+        // The parents of the recomputed nodes are the dirty nodes of the next level
+        size_t parents = 0;
+        for (size_t j = 0; j < nodes.size(); j++) {
+            uint64_t parent = nodes[j] / md6_tree_fanout;
+            if (parents == 0 || nodes[parents - 1] != parent) nodes[parents++] = parent;
+        }
+        nodes.resize(parents);
+    }
+
+    return md6_final_root(&t->st, t->C[levels].data(), hashval);
+}
+
+// Size the index for a message of length bytes, for leaves that are compressed elsewhere into t->C[1]
+int md6_tree_prepare(md6_tree *t, uint64_t length) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (!t->st.initialized) return MD6_STATENOTINIT;
+
+    uint64_t count[md6_max_stack_height] = {0};
+    int levels = md6_tree_shape(length, count);
+    if (count[levels] != 1 || levels > t->st.L) return MD6_BAD_L;
+
+    t->length = length;
+    t->levels = levels;
+    for (int ell = 1; ell < md6_max_stack_height; ell++)
+        t->C[ell].resize((ell <= levels) ? count[ell] * c : 0);
+
+    return MD6_SUCCESS;
+}
+
+// Build the levels above the leaves and the root once t->C[1] holds every leaf of a prepared index
+int md6_tree_finish(md6_tree *t, unsigned char *hashval) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (t->levels == 0) return MD6_STATENOTINIT;
+
+    uint64_t count[md6_max_stack_height] = {0};
+    md6_tree_shape(t->length, count);
+
+    std::vector<uint64_t> nodes;
+    for (int ell = 2; ell <= t->levels; ell++) {
+        nodes.resize(count[ell]);
+        std::iota(nodes.begin(), nodes.end(), 0);
+        int err = md6_tree_compress_level(t, nullptr, ell, nodes, count);
+        if (err) {
+            t->levels = 0;
+            return err;
+        }
+    }
+
+    return md6_final_root(&t->st, t->C[t->levels].data(), hashval);
+}
+
+// Write the index to a file so that it survives between runs. The format is native-endian,
+// it is meant to be read back on the machine that wrote it.
+int md6_tree_save(const md6_tree *t, const char *path) {
+    if (t == nullptr) return MD6_NULLSTATE;
+    if (t->levels == 0) return MD6_STATENOTINIT;
+
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr) return MD6_BAD_INDEX;
+
+    int32_t params[5] = {t->st.d, t->st.keylen, t->st.L, t->st.r, t->levels};
+    bool ok = fwrite(md6_tree_magic, sizeof(md6_tree_magic), 1, file) == 1 &&
+              fwrite(&md6_tree_version, sizeof(md6_tree_version), 1, file) == 1 &&
+              fwrite(params, sizeof(params), 1, file) == 1 &&
+              fwrite(t->key, sizeof(t->key), 1, file) == 1 &&
+              fwrite(&t->length, sizeof(t->length), 1, file) == 1;
+
+    for (int ell = 1; ok && ell <= t->levels; ell++)
+        ok = fwrite(t->C[ell].data(), sizeof(md6_word), t->C[ell].size(), file) == t->C[ell].size();
+
+    if (fclose(file) != 0) ok = false;
+    return ok ? MD6_SUCCESS : MD6_BAD_INDEX;
+}
+
+// Load an index written by md6_tree_save; the hash parameters are taken from the file
+int md6_tree_load(md6_tree *t, const char *path) {
+    if (t == nullptr) return MD6_NULLSTATE;
+
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) return MD6_BAD_INDEX;
+
+    char magic[sizeof(md6_tree_magic)];
+    uint32_t version;
+    int32_t params[5];
+    unsigned char key[sizeof(t->key)];
+    uint64_t length;
+
+    bool ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+              memcmp(magic, md6_tree_magic, sizeof(magic)) == 0 &&
+              fread(&version, sizeof(version), 1, file) == 1 && version == md6_tree_version &&
+              fread(params, sizeof(params), 1, file) == 1 &&
+              fread(key, sizeof(key), 1, file) == 1 &&
+              fread(&length, sizeof(length), 1, file) == 1;
+
+    uint64_t count[md6_max_stack_height] = {0};
+    int levels = ok ? md6_tree_shape(length, count) : 0;
+    ok = ok && levels == params[4] && count[levels] == 1 && levels <= params[2] &&
+         md6_tree_init(t, params[0], key, params[1], params[2], params[3]) == MD6_SUCCESS;
+
+    if (ok) {
+        t->length = length;
+        t->levels = levels;
+        for (int ell = 1; ok && ell <= levels; ell++) {
+            t->C[ell].resize(count[ell] * c);
+            ok = fread(t->C[ell].data(), sizeof(md6_word), t->C[ell].size(), file) == t->C[ell].size();
+        }
+        // Anything after the last level is not an index this code wrote
+        ok = ok && fgetc(file) == EOF;
+        if (!ok) t->levels = 0;
+    }
+
+    fclose(file);
+    return ok ? MD6_SUCCESS : MD6_BAD_INDEX;
+}
@@ -0,0 +1,50 @@
+#include "md6_word.h"
+
+bool md6_word_hash8(int d, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    return md6_word_hash<uint8_t>(d, data, length, hashval);
+}
+
+bool md6_word_hash16(int d, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    return md6_word_hash<uint16_t>(d, data, length, hashval);
+}
+
+bool md6_word_hash32(int d, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    return md6_word_hash<uint32_t>(d, data, length, hashval);
+}
+
+bool md6_word_hash64(int d, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    return md6_word_hash<uint64_t>(d, data, length, hashval);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+// The templates are always_inline, so the whole hash is compiled for AVX2 inside these
+__attribute__((target("avx2"))) bool md6_word_hash32_avx2(int d, const unsigned char *data, uint64_t length,
+                                                          unsigned char *hashval) {
+    return md6_word_hash<uint32_t, 8>(d, data, length, hashval);
+}
+
+__attribute__((target("avx2"))) bool md6_word_hash64_avx2(int d, const unsigned char *data, uint64_t length,
+                                                          unsigned char *hashval) {
+    return md6_word_hash<uint64_t, 4>(d, data, length, hashval);
+}
+
+bool md6_word_has_avx2() {
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool md6_word_hash32_avx2(int d, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    return md6_word_hash<uint32_t, 8>(d, data, length, hashval);
+}
+
+bool md6_word_hash64_avx2(int d, const unsigned char *data, uint64_t length, unsigned char *hashval) {
+    return md6_word_hash<uint64_t, 4>(d, data, length, hashval);
+}
+
+bool md6_word_has_avx2() {
+    return false;
+}
+
+#endif
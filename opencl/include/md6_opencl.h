@@ -0,0 +1,14 @@
+#ifndef EEE4120F_YODA_MD6_OPENCL_H
+#define EEE4120F_YODA_MD6_OPENCL_H
+
+#include "OpenCLResources.h"
+#include "md6.h"
+
+// Hash a message in MD6 tree mode on the device and return the kernel execution time in seconds
+double md6HashOpenCL(OpenCLResources& resources, const unsigned char* data, uint64_t length, const md6_state* params,
+                     unsigned char* hashval);
+
+void runMD6Tests();
+void singleTestMD6();
+
+#endif //EEE4120F_YODA_MD6_OPENCL_H
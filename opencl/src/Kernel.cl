@@ -121,3 +121,108 @@ __kernel void md5_hash(__global unsigned char* input, __global unsigned char* ou
         output[i + 12] = (uchar)(D >> (i * 8));
     }
 }
+
+// ---------------------------------------------------------------------------------------------------------------
+// MD6: one tree node (ell, i) per work-item. The packing matches md6_standard_compress on the host:
+// N = Q (15 words) | K (8 words) | U | V | B (64 words), with the Q/K prefix and the fixed fields of V
+// passed in from the host's md6_state.
+// ---------------------------------------------------------------------------------------------------------------
+
+#define MD6_N 89
+#define MD6_C 16
+#define MD6_B 64
+#define MD6_PREFIX 23
+#define MD6_LEAF_BYTES 512
+#define MD6_FANOUT 4
+
+// Right/left shift amounts for each of the 16 steps of a round
+__constant int md6_RL[16][2] = {
+        {10, 11}, {5, 24}, {13, 9}, {10, 16}, {11, 15}, {12, 9},
+        {2, 27}, {7, 15}, {14, 6}, {15, 2}, {7, 29}, {13, 8},
+        {11, 15}, {7, 5}, {6, 31}, {12, 9}
+};
+
+// Run r rounds over N and write the 16-word chaining value to C. Only the last 89 words of the
+// compression array are ever read, so A is a ring buffer: A[i - 89] sits in the slot A[i] is written to.
+static void md6_compress(ulong *A, uint r, __global ulong *C) {
+    ulong S = 0x0123456789abcdefUL;
+    uint pos = 0;
+
+    for (uint j = 0; j < r; j++) {
+        #pragma unroll
+        for (int step = 0; step < 16; step++) {
+            uint t17 = pos + 72; if (t17 >= MD6_N) t17 -= MD6_N;
+            uint t18 = pos + 71; if (t18 >= MD6_N) t18 -= MD6_N;
+            uint t21 = pos + 68; if (t21 >= MD6_N) t21 -= MD6_N;
+            uint t31 = pos + 58; if (t31 >= MD6_N) t31 -= MD6_N;
+            uint t67 = pos + 22; if (t67 >= MD6_N) t67 -= MD6_N;
+
+            ulong x = S;
+            x ^= A[pos];
+            x ^= A[t17];
+            x ^= (A[t18] & A[t21]);
+            x ^= (A[t31] & A[t67]);
+            x ^= (x >> md6_RL[step][0]);
+            A[pos] = x ^ (x << md6_RL[step][1]);
+
+            if (++pos == MD6_N) pos = 0;
+        }
+        S = (S << 1) ^ (S >> 63) ^ (S & 0x7311c2812425cfa0UL);
+    }
+
+    // The last 16 words written end just before pos
+    for (int j = 0; j < MD6_C; j++) {
+        uint slot = pos + MD6_N - MD6_C + j;
+        if (slot >= MD6_N) slot -= MD6_N;
+        C[j] = A[slot];
+    }
+}
+
+// Fill the Q/K prefix, U and V of A; the caller fills B at A[MD6_PREFIX + 2 ...]
+static void md6_pack(ulong *A, __constant ulong *prefix, ulong V_base, uint ell, ulong i, uint z, uint p) {
+    for (int j = 0; j < MD6_PREFIX; j++) A[j] = prefix[j];
+    A[MD6_PREFIX] = ((ulong) ell << 56) | i;
+    A[MD6_PREFIX + 1] = V_base | ((ulong) z << 36) | ((ulong) p << 20);
+}
+
+// Level 1: each leaf is up to 512 message bytes, read as big-endian words
+__kernel void md6_compress_leaves(__global const uchar *input, ulong inputSize, __global ulong *output,
+                                  __constant ulong *prefix, ulong V_base, uint z, uint r, ulong nodes) {
+    ulong i = get_global_id(0);
+    if (i >= nodes) return;
+
+    ulong start = i * MD6_LEAF_BYTES;
+    uint bytes = (uint) min((ulong) MD6_LEAF_BYTES, inputSize - start);
+
+    ulong A[MD6_N];
+    md6_pack(A, prefix, V_base, 1, i, z, MD6_B * 64 - bytes * 8);
+
+    for (uint j = 0; j < MD6_B; j++) {
+        ulong word = 0;
+        for (uint k = 0; k < 8; k++) {
+            uint offset = j * 8 + k;
+            word = (word << 8) | ((offset < bytes) ? input[start + offset] : 0);
+        }
+        A[MD6_PREFIX + 2 + j] = word;
+    }
+
+    md6_compress(A, r, output + i * MD6_C);
+}
+
+// Levels above 1: each node is the concatenation of up to 4 chaining values of the level below
+__kernel void md6_compress_nodes(__global const ulong *input, ulong inputNodes, __global ulong *output,
+                                 __constant ulong *prefix, ulong V_base, uint ell, uint z, uint r, ulong nodes) {
+    ulong i = get_global_id(0);
+    if (i >= nodes) return;
+
+    ulong first = i * MD6_FANOUT;
+    uint children = (uint) min((ulong) MD6_FANOUT, inputNodes - first);
+
+    ulong A[MD6_N];
+    md6_pack(A, prefix, V_base, ell, i, z, MD6_B * 64 - children * MD6_C * 64);
+
+    for (uint j = 0; j < MD6_B; j++)
+        A[MD6_PREFIX + 2 + j] = (j < children * MD6_C) ? input[first * MD6_C + j] : 0;
+
+    md6_compress(A, r, output + i * MD6_C);
+}
@@ -2,92 +2,12 @@
 // Created by David Young on 2024/05/02.
 //
 
-#ifdef __APPLE__
-#include <OpenCL/cl.h>
-#else
-#include<CL/cl.h>
-#endif
-
 #include <iostream>
 #include <fstream>
 #include <vector>
 
-#include "OpenCLError.h"
-
-// Class to manage OpenCL resources
-class OpenCLResources {
-private:
-    cl_platform_id platform;
-    cl_device_id device;
-    cl_context context;
-    cl_command_queue queue;
-    cl_program program;
-
-public:
-    OpenCLResources() {
-        cl_int err;
-
-        // Initialize OpenCL Platform
-        cl_uint platformCount = 0;
-        clGetPlatformIDs(0, nullptr, &platformCount);
-        std::unique_ptr<cl_platform_id[]> platforms(new cl_platform_id[platformCount]);
-        clGetPlatformIDs(platformCount, platforms.get(), nullptr);
-        platform = platforms[0];
-
-        // Initialize OpenCL Device
-        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &device, nullptr);
-        if (err == CL_DEVICE_NOT_FOUND) {
-            err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &device, nullptr);
-        }
-        if (err != CL_SUCCESS) {
-            throw OpenCLError("Failed to initialize OpenCL device");
-        }
-
-        // Create Context
-        context = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
-
-        // Create Command Queue
-#if defined(CL_VERSION_2_0)
-        const cl_queue_properties props[] = { CL_QUEUE_PROPERTIES, CL_QUEUE_PROFILING_ENABLE, 0 };
-        queue = clCreateCommandQueueWithProperties(context, device, props, &err);
-#else
-        queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &err);
-#endif
-
-        // Read and compile the kernel
-        FILE* program_handle = fopen("bin/Kernel.cl", "r");
-        fseek(program_handle, 0, SEEK_END);
-        size_t program_size = ftell(program_handle);
-        rewind(program_handle);
-        std::unique_ptr<char[]> program_buffer(new char[program_size + 1]);
-        program_buffer[program_size] = '\0';
-        fread(program_buffer.get(), sizeof(char), program_size, program_handle);
-        fclose(program_handle);
-
-        program = clCreateProgramWithSource(context, 1, (const char**)&program_buffer, &program_size, nullptr);
-        err = clBuildProgram(program, 0, nullptr, nullptr, nullptr, nullptr);
-        if (err != CL_SUCCESS) {
-            // The program failed to build, print the build log for debugging
-            size_t log_size;
-            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, nullptr, &log_size);
-            std::unique_ptr<char[]> log(new char[log_size]);
-            clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, log_size, log.get(), nullptr);
-            throw OpenCLError(std::string("Build failed; error=") + std::to_string(err) + ", log:\n" + log.get());
-        }
-    }
-
-    ~OpenCLResources() {
-        clReleaseProgram(program);
-        clReleaseCommandQueue(queue);
-        clReleaseContext(context);
-    }
-
-    cl_platform_id getPlatform() const { return platform; }
-    cl_device_id getDevice() const { return device; }
-    cl_context getContext() const { return context; }
-    cl_command_queue getQueue() const { return queue; }
-    cl_program getProgram() const { return program; }
-};
+#include "OpenCLResources.h"
+#include "md6_opencl.h"
 
 // Function to run MD5 hashing and return execution times
 double runMD5Hashing(OpenCLResources& resources, const std::vector<char>& message, size_t local_size, size_t numBlocks, bool printOutput = false) {
@@ -273,6 +193,12 @@ int main() {
     // Run a single test
     singleTest();
 
+    // Run the MD6 tree-mode tests on the device
+    singleTestMD6();
+
+    // Compare MD6 throughput on the device with the threaded CPU path
+    // runMD6Tests();
+
     // Run multiple tests - note that this will take a long time to run
     // runTests();
 
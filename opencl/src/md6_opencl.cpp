@@ -0,0 +1,228 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "md6_opencl.h"
+#include "md6_tree.h"
+
+// Hash a message in MD6 tree mode on the OpenCL device. Every node of a level is compressed by its own
+// work-item, the levels are launched bottom-up on the in-order queue and only the root is read back.
+double md6HashOpenCL(OpenCLResources& resources, const unsigned char* data, uint64_t length, const md6_state* params,
+                     unsigned char* hashval) {
+    cl_int err;
+    cl_context context = resources.getContext();
+    cl_command_queue queue = resources.getQueue();
+
+    // Number of nodes on each level, the root being the single node of the last level
+    std::vector<cl_ulong> count = {0, (length == 0) ? 1 : (length + md6_leaf_bytes - 1) / md6_leaf_bytes};
+    while (count.back() > 1) {
+        count.push_back((count.back() + md6_tree_fanout - 1) / md6_tree_fanout);
+    }
+    cl_uint levels = count.size() - 1;
+    if ((int) levels > params->L || levels >= md6_max_stack_height - 1) {
+        throw OpenCLError("Message needs more than L tree levels");
+    }
+
+    CLKernel leafKernel(clCreateKernel(resources.getProgram(), "md6_compress_leaves", &err));
+    if (err != CL_SUCCESS) {
+        throw OpenCLError("Failed to create MD6 leaf kernel");
+    }
+    CLKernel nodeKernel(clCreateKernel(resources.getProgram(), "md6_compress_nodes", &err));
+    if (err != CL_SUCCESS) {
+        throw OpenCLError("Failed to create MD6 node kernel");
+    }
+
+    // Create the input, prefix and per-level chaining value buffers
+    cl_ulong inputSize = length;
+    CLBuffer input(clCreateBuffer(context, CL_MEM_READ_ONLY, (length == 0) ? 1 : length, nullptr, &err));
+    if (err != CL_SUCCESS) {
+        throw OpenCLError("Failed to create MD6 input buffer");
+    }
+    CLBuffer prefix(clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(params->N_prefix),
+                                   (void*) params->N_prefix, &err));
+    if (err != CL_SUCCESS) {
+        throw OpenCLError("Failed to create MD6 prefix buffer");
+    }
+    std::vector<CLBuffer> levelBuffers(levels + 1);
+    for (cl_uint ell = 1; ell <= levels; ell++) {
+        levelBuffers[ell].reset(clCreateBuffer(context, CL_MEM_READ_WRITE, count[ell] * md6_c * sizeof(cl_ulong),
+                                               nullptr, &err));
+        if (err != CL_SUCCESS) {
+            throw OpenCLError("Failed to create MD6 level buffer");
+        }
+    }
+
+    // clSetKernelArg wants the address of each handle
+    cl_mem input_buffer = input.get();
+    cl_mem prefix_buffer = prefix.get();
+    std::vector<cl_mem> level_buffers(levels + 1, nullptr);
+    for (cl_uint ell = 1; ell <= levels; ell++) {
+        level_buffers[ell] = levelBuffers[ell].get();
+    }
+
+    if (length > 0) {
+        err = clEnqueueWriteBuffer(queue, input_buffer, CL_TRUE, 0, length, data, 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            throw OpenCLError("Failed to write to source array");
+        }
+    }
+
+    cl_ulong V_base = params->V_base;
+    cl_uint r = params->r;
+    std::vector<CLEvent> events(levels + 1);
+
+    for (cl_uint ell = 1; ell <= levels; ell++) {
+        cl_uint z = (ell == levels) ? 1 : 0;
+        cl_ulong nodes = count[ell];
+        size_t global_size = count[ell];
+
+        cl_kernel kernel = (ell == 1) ? leafKernel.get() : nodeKernel.get();
+        int arg = 0;
+        if (ell == 1) {
+            clSetKernelArg(kernel, arg++, sizeof(cl_mem), &input_buffer);
+            clSetKernelArg(kernel, arg++, sizeof(cl_ulong), &inputSize);
+        } else {
+            clSetKernelArg(kernel, arg++, sizeof(cl_mem), &level_buffers[ell - 1]);
+            clSetKernelArg(kernel, arg++, sizeof(cl_ulong), &count[ell - 1]);
+        }
+        clSetKernelArg(kernel, arg++, sizeof(cl_mem), &level_buffers[ell]);
+        clSetKernelArg(kernel, arg++, sizeof(cl_mem), &prefix_buffer);
+        clSetKernelArg(kernel, arg++, sizeof(cl_ulong), &V_base);
+        if (ell > 1) {
+            clSetKernelArg(kernel, arg++, sizeof(cl_uint), &ell);
+        }
+        clSetKernelArg(kernel, arg++, sizeof(cl_uint), &z);
+        clSetKernelArg(kernel, arg++, sizeof(cl_uint), &r);
+        clSetKernelArg(kernel, arg++, sizeof(cl_ulong), &nodes);
+
+        // The queue is in order, so each level sees the chaining values of the one below
+        cl_event event;
+        err = clEnqueueNDRangeKernel(queue, kernel, 1, nullptr, &global_size, nullptr, 0, nullptr, &event);
+        if (err != CL_SUCCESS) {
+            throw OpenCLError("Failed to execute MD6 kernel");
+        }
+        events[ell].reset(event);
+    }
+
+    // Read back only the root chaining value
+    md6_word root[md6_c];
+    err = clEnqueueReadBuffer(queue, level_buffers[levels], CL_TRUE, 0, sizeof(root), root, 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        throw OpenCLError("Failed to read output array");
+    }
+
+    // Add up the execution time of every level
+    double executionTime = 0;
+    for (cl_uint ell = 1; ell <= levels; ell++) {
+        cl_ulong startTime, endTime;
+        clGetEventProfilingInfo(events[ell].get(), CL_PROFILING_COMMAND_START, sizeof(startTime), &startTime, nullptr);
+        clGetEventProfilingInfo(events[ell].get(), CL_PROFILING_COMMAND_END, sizeof(endTime), &endTime, nullptr);
+        executionTime += (endTime - startTime) * 1e-9;  // Convert from nanoseconds to seconds
+    }
+
+    md6_state st = *params;
+    md6_final_root(&st, root, hashval);
+    return executionTime;
+}
+
+// Digest of the same message from the sequential CPU implementation
+static void md6HashCPU(const unsigned char* data, uint64_t length, int d, unsigned char* hashval) {
+    auto* st = (md6_state*) malloc(sizeof(md6_state));
+    md6_init(st, d);
+    md6_update(st, data, length * 8);
+    md6_final(st, hashval);
+    free(st);
+}
+
+static std::string toHex(const unsigned char* digest, int byteLen) {
+    std::string hex;
+    char byte[3];
+    for (int i = 0; i < byteLen; i++) {
+        snprintf(byte, sizeof(byte), "%02x", digest[i]);
+        hex += byte;
+    }
+    return hex;
+}
+
+void runMD6Tests() {
+    OpenCLResources resources;
+
+    auto* params = (md6_state*) malloc(sizeof(md6_state));
+    md6_init(params, 256);
+
+    auto* tree = new md6_tree;
+    md6_tree_init(tree, 256, nullptr, 0, md6_default_L, 40 + 256 / 4);
+
+    std::ofstream outputFile("md6_execution_times.csv", std::ios_base::app);
+    outputFile << "Message Size,OpenCL Time,CPU Threaded Time\n";
+
+    unsigned char deviceHash[32], cpuHash[32], expected[32];
+
+    for (uint64_t inputSize = 1 << 12; inputSize <= (1 << 26); inputSize <<= 2) {
+        std::vector<unsigned char> message(inputSize);
+        for (uint64_t i = 0; i < inputSize; i++) message[i] = (unsigned char) (i * 2654435761u >> 13);
+
+        std::cout << "Running MD6-256 on input size " << inputSize << "\n";
+
+        double deviceTime = md6HashOpenCL(resources, message.data(), inputSize, params, deviceHash);
+
+        // CPU path: leaves compressed across all cores
+        auto start = std::chrono::high_resolution_clock::now();
+        md6_tree_hash(tree, message.data(), inputSize, cpuHash);
+        auto stop = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> cpuTime = stop - start;
+
+        md6HashCPU(message.data(), inputSize, 256, expected);
+
+        std::cout << "OpenCL: " << deviceTime << "s (" << inputSize / deviceTime / 1e6 << " MB/s), CPU threaded: "
+                  << cpuTime.count() << "s (" << inputSize / cpuTime.count() / 1e6 << " MB/s)"
+                  << (memcmp(deviceHash, expected, 32) == 0 && memcmp(cpuHash, expected, 32) == 0
+                      ? "" : " (DIGEST MISMATCH)") << "\n";
+
+        outputFile << inputSize << "," << deviceTime << "," << cpuTime.count() << "\n";
+    }
+
+    outputFile.close();
+    delete tree;
+    free(params);
+}
+
+void singleTestMD6() {
+    OpenCLResources resources;
+    const char* message = "test";
+    const int digestSizes[3] = {128, 256, 512};
+    const std::string knownHashes[3] = {
+            "a133b0efa199156be653427c6ab85d3d",
+            "93c8a7d0ff132f325138a82b2baa98c12a7c9ac982feb6c5b310a1ca713615bd",
+            "d96ce883f4632f826b3bb553fe5cbff8fb00b32b3534b39aa0c0899d1199a8cf28d77e49f2465517dfb12c0f3268b90f8a13d94e6730a74ed2e8312242a9e937"
+    };
+
+    auto* params = (md6_state*) malloc(sizeof(md6_state));
+    unsigned char hash[64];
+
+    for (int j = 0; j < 3; j++) {
+        md6_init(params, digestSizes[j]);
+        double exec_time = md6HashOpenCL(resources, (const unsigned char*) message, strlen(message), params, hash);
+        std::string hex = toHex(hash, digestSizes[j] / 8);
+
+        std::cout << "MD6-" << digestSizes[j] << " hash of '" << message << "': " << hex
+                  << (hex == knownHashes[j] ? " (matches known hash)" : " (DOES NOT MATCH known hash)") << "\n";
+        std::cout << "Execution time: " << exec_time << " seconds\n";
+    }
+
+    // A message spanning several tree levels must match md6_final as well
+    std::vector<unsigned char> longMessage(100000);
+    for (size_t i = 0; i < longMessage.size(); i++) longMessage[i] = (unsigned char) i;
+    unsigned char expected[32];
+
+    md6_init(params, 256);
+    md6HashOpenCL(resources, longMessage.data(), longMessage.size(), params, hash);
+    md6HashCPU(longMessage.data(), longMessage.size(), 256, expected);
+    std::cout << "MD6-256 of a " << longMessage.size() << " byte message "
+              << (memcmp(hash, expected, 32) == 0 ? "matches" : "DOES NOT MATCH") << " md6_final\n";
+
+    free(params);
+}
@@ -140,7 +140,7 @@ module md5 (
                         AA = DD;
                         DD = CC;
                         CC = BB;
-                        BB = (BB + ((F << S[i]) | (F >>> (32 - S[i])))) % 32'hFFFFFFFF;
+                        BB = BB + ((F << S[i]) | (F >>> (32 - S[i])));
 
                         i = i + 1;
                     end else begin
@@ -0,0 +1,83 @@
+`timescale 1ns / 1ps
+
+// N_CORES md5_core instances behind a round-robin dispatcher, so that independent single-block messages
+// are hashed concurrently. Messages are handed to the cores in turn and the digests are collected in the
+// same turn, which makes the cores' result registers the reorder buffer: digests leave in the order the
+// messages arrived, whatever the output backpressure.
+module md5_array #(
+        parameter N_CORES = 4,
+        parameter TAG_WIDTH = 8
+    ) (
+        input wire clk,
+        input wire reset,
+
+        // Message input, as for the md5 core
+        input wire in_valid,
+        output wire in_ready,
+        input wire [0:511] message,         // Message right-aligned in the block
+        input wire [63:0] message_len,      // Length of the message in bits (up to 440)
+        input wire [TAG_WIDTH-1:0] in_tag,  // Returned with the digest
+
+        // Digest output, in message order
+        output wire out_valid,
+        input wire out_ready,
+        output wire [127:0] digest,
+        output wire [TAG_WIDTH-1:0] out_tag
+    );
+
+    localparam IDX_WIDTH = (N_CORES > 1) ? $clog2(N_CORES) : 1;
+
+    // Pad the message once, in front of all cores: left-align it, append the '1' bit and put the
+    // 64-bit little-endian bit length at the end of the block
+    wire [0:511] aligned = message << (10'd512 - message_len[9:0]);
+    wire [0:511] marker = {1'b1, 511'b0} >> message_len[9:0];
+    wire [0:511] with_marker = aligned | marker;
+    wire [0:511] block = {with_marker[0:447],
+                          message_len[7:0], message_len[15:8], message_len[23:16], message_len[31:24],
+                          message_len[39:32], message_len[47:40], message_len[55:48], message_len[63:56]};
+
+    reg [IDX_WIDTH-1:0] next;     // Core that receives the next message
+    reg [IDX_WIDTH-1:0] out_ptr;  // Core that holds the next digest in message order
+    reg [TAG_WIDTH-1:0] tags [0:N_CORES-1];
+
+    wire [N_CORES-1:0] core_idle;
+    wire [N_CORES-1:0] core_valid;
+    wire [127:0] core_digest [0:N_CORES-1];
+
+    assign in_ready = core_idle[next] && !reset;
+    assign out_valid = core_valid[out_ptr];
+    assign digest = core_digest[out_ptr];
+    assign out_tag = tags[out_ptr];
+
+    genvar k;
+    generate
+        for (k = 0; k < N_CORES; k = k + 1) begin : core
+            md5_core u_core (
+                .clk(clk),
+                .reset(reset),
+                .start(in_valid && in_ready && next == k),
+                .block(block),
+                .ack(out_valid && out_ready && out_ptr == k),
+                .idle(core_idle[k]),
+                .valid(core_valid[k]),
+                .digest(core_digest[k])
+            );
+        end
+    endgenerate
+
+    always @(posedge clk) begin
+        if (reset) begin
+            next <= 0;
+            out_ptr <= 0;
+        end else begin
+            if (in_valid && in_ready) begin
+                tags[next] <= in_tag;
+                next <= (next == N_CORES - 1) ? 0 : next + 1;
+            end
+
+            if (out_valid && out_ready) begin
+                out_ptr <= (out_ptr == N_CORES - 1) ? 0 : out_ptr + 1;
+            end
+        end
+    end
+endmodule
@@ -0,0 +1,135 @@
+`timescale 1ns / 1ps
+
+module tb_md5_array;
+    // Number of cores, and test vectors in VECTOR_FILE written by `md5_cpp --vectors` from the C++ calculate()
+    parameter N_CORES = 4;
+    parameter NUM_VECTORS = 1024;
+    parameter VECTOR_FILE = "md5_vectors.hex";
+
+    // Inputs
+    reg clk;
+    reg reset;
+    reg in_valid;
+    reg [0:511] message;
+    reg [63:0] message_len;
+    reg [15:0] in_tag;
+    reg out_ready;
+
+    // Outputs
+    wire in_ready;
+    wire out_valid;
+    wire [127:0] digest;
+    wire [15:0] out_tag;
+
+    // Each vector is a padded single-block message followed by its expected digest
+    reg [639:0] vectors [0:NUM_VECTORS-1];
+    reg [0:511] block;
+
+    integer j;
+    integer issued;
+    integer received;
+    integer errors;
+    integer cycle;
+    integer first_in_cycle;
+    integer last_out_cycle;
+
+    // Instantiate the Unit Under Test (UUT)
+    md5_array #(.N_CORES(N_CORES), .TAG_WIDTH(16)) uut (
+        .clk(clk),
+        .reset(reset),
+        .in_valid(in_valid),
+        .in_ready(in_ready),
+        .message(message),
+        .message_len(message_len),
+        .in_tag(in_tag),
+        .out_valid(out_valid),
+        .out_ready(out_ready),
+        .digest(digest),
+        .out_tag(out_tag)
+    );
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #0.185 clk = !clk;  // Clock with a period of 370ps (2.7 GHz like iMac CPU)
+    end
+
+    // Count cycles and check that digests leave in message order and match their vectors
+    always @(posedge clk) begin
+        cycle <= cycle + 1;
+        if (out_valid && out_ready) begin
+            last_out_cycle = cycle;
+
+            if (out_tag != received) begin
+                errors = errors + 1;
+                $display("Digest %0d arrived out of order (tag %0d)", received, out_tag);
+            end else if (digest !== vectors[out_tag][127:0]) begin
+                errors = errors + 1;
+                $display("Vector %0d: digest %h, expected %h", out_tag, digest, vectors[out_tag][127:0]);
+            end
+
+            received = received + 1;
+        end
+    end
+
+    // Test vectors and checker
+    initial begin
+        $readmemh(VECTOR_FILE, vectors);
+
+        // Initialize Inputs
+        reset = 1;
+        in_valid = 0;
+        message = 0;
+        message_len = 0;
+        in_tag = 0;
+        out_ready = 1;
+        cycle = 0;
+        issued = 0;
+        received = 0;
+        errors = 0;
+
+        // Wait for global reset to finish
+        @(posedge clk);
+        @(posedge clk);
+        #0.1;
+        reset = 0;
+
+        // Offer a new message every cycle; the array takes one whenever the next core is free
+        first_in_cycle = cycle;
+        while (issued < NUM_VECTORS) begin
+            // Recover the message and its length from the padded block, right-aligned as md5 takes it
+            block = vectors[issued][639:128];
+            for (j = 0; j < 8; j = j + 1) begin
+                message_len[8*j +: 8] = block[448 + 8*j +: 8];
+            end
+            message = block >> (512 - message_len);
+            in_tag = issued;
+            in_valid = 1;
+
+            @(posedge clk);
+            if (in_ready) issued = issued + 1;
+            #0.1;
+        end
+        in_valid = 0;
+
+        // Drain the cores
+        wait (received == NUM_VECTORS);
+        @(posedge clk);
+
+        $display("Cores: %0d, blocks: %0d in %0d cycles (%f blocks/cycle, %f blocks/cycle per core)",
+                 N_CORES, NUM_VECTORS, last_out_cycle - first_in_cycle + 1,
+                 NUM_VECTORS * 1.0 / (last_out_cycle - first_in_cycle + 1),
+                 NUM_VECTORS * 1.0 / (last_out_cycle - first_in_cycle + 1) / N_CORES);
+
+        if (errors == 0) begin
+            $display("Test Passed. All %0d digests match the C++ implementation, in order.", NUM_VECTORS);
+        end else begin
+            $display("Test Failed. %0d of %0d digests are wrong or out of order.", errors, NUM_VECTORS);
+        end
+
+        // End simulation
+        #0.37;
+        $finish;
+    end
+
+endmodule
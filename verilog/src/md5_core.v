@@ -0,0 +1,122 @@
+`timescale 1ns / 1ps
+
+// Iterative MD5 block core for the md5_array: hashes one padded 512-bit block from the initial value,
+// one round per clock, and holds the digest until it is acknowledged. Unlike md5 it needs no reset
+// between messages and has no variable-bound loops, so it synthesizes.
+module md5_core (
+        input wire clk,
+        input wire reset,
+        input wire start,          // Load block and begin; ignored unless idle
+        input wire [0:511] block,  // Padded 512-bit block, first message byte in block[0:7]
+        input wire ack,            // The digest has been taken
+        output wire idle,          // Ready for a new block
+        output reg valid,          // digest holds the result of the last block
+        output wire [127:0] digest
+    );
+
+    // The constants for each round
+    function [31:0] md5_k(input [5:0] i);
+        case (i)
+            0:  md5_k = 32'hd76aa478;   1:  md5_k = 32'he8c7b756;   2:  md5_k = 32'h242070db;   3:  md5_k = 32'hc1bdceee;
+            4:  md5_k = 32'hf57c0faf;   5:  md5_k = 32'h4787c62a;   6:  md5_k = 32'ha8304613;   7:  md5_k = 32'hfd469501;
+            8:  md5_k = 32'h698098d8;   9:  md5_k = 32'h8b44f7af;   10: md5_k = 32'hffff5bb1;   11: md5_k = 32'h895cd7be;
+            12: md5_k = 32'h6b901122;   13: md5_k = 32'hfd987193;   14: md5_k = 32'ha679438e;   15: md5_k = 32'h49b40821;
+            16: md5_k = 32'hf61e2562;   17: md5_k = 32'hc040b340;   18: md5_k = 32'h265e5a51;   19: md5_k = 32'he9b6c7aa;
+            20: md5_k = 32'hd62f105d;   21: md5_k = 32'h02441453;   22: md5_k = 32'hd8a1e681;   23: md5_k = 32'he7d3fbc8;
+            24: md5_k = 32'h21e1cde6;   25: md5_k = 32'hc33707d6;   26: md5_k = 32'hf4d50d87;   27: md5_k = 32'h455a14ed;
+            28: md5_k = 32'ha9e3e905;   29: md5_k = 32'hfcefa3f8;   30: md5_k = 32'h676f02d9;   31: md5_k = 32'h8d2a4c8a;
+            32: md5_k = 32'hfffa3942;   33: md5_k = 32'h8771f681;   34: md5_k = 32'h6d9d6122;   35: md5_k = 32'hfde5380c;
+            36: md5_k = 32'ha4beea44;   37: md5_k = 32'h4bdecfa9;   38: md5_k = 32'hf6bb4b60;   39: md5_k = 32'hbebfbc70;
+            40: md5_k = 32'h289b7ec6;   41: md5_k = 32'heaa127fa;   42: md5_k = 32'hd4ef3085;   43: md5_k = 32'h04881d05;
+            44: md5_k = 32'hd9d4d039;   45: md5_k = 32'he6db99e5;   46: md5_k = 32'h1fa27cf8;   47: md5_k = 32'hc4ac5665;
+            48: md5_k = 32'hf4292244;   49: md5_k = 32'h432aff97;   50: md5_k = 32'hab9423a7;   51: md5_k = 32'hfc93a039;
+            52: md5_k = 32'h655b59c3;   53: md5_k = 32'h8f0ccc92;   54: md5_k = 32'hffeff47d;   55: md5_k = 32'h85845dd1;
+            56: md5_k = 32'h6fa87e4f;   57: md5_k = 32'hfe2ce6e0;   58: md5_k = 32'ha3014314;   59: md5_k = 32'h4e0811a1;
+            60: md5_k = 32'hf7537e82;   61: md5_k = 32'hbd3af235;   62: md5_k = 32'h2ad7d2bb;   default: md5_k = 32'heb86d391;
+        endcase
+    endfunction
+
+    // The rotation amounts for each round
+    function [4:0] md5_s(input [5:0] i);
+        case ({i[5:4], i[1:0]})
+            4'b0000: md5_s = 7;   4'b0001: md5_s = 12;  4'b0010: md5_s = 17;  4'b0011: md5_s = 22;
+            4'b0100: md5_s = 5;   4'b0101: md5_s = 9;   4'b0110: md5_s = 14;  4'b0111: md5_s = 20;
+            4'b1000: md5_s = 4;   4'b1001: md5_s = 11;  4'b1010: md5_s = 16;  4'b1011: md5_s = 23;
+            4'b1100: md5_s = 6;   4'b1101: md5_s = 10;  4'b1110: md5_s = 15;  default: md5_s = 21;
+        endcase
+    endfunction
+
+    // The message word used by each round (all arithmetic is modulo 16)
+    function [3:0] md5_g(input [5:0] i);
+        case (i[5:4])
+            2'd0: md5_g = i[3:0];
+            2'd1: md5_g = 5*i[3:0] + 1;
+            2'd2: md5_g = 3*i[3:0] + 5;
+            default: md5_g = 7*i[3:0];
+        endcase
+    endfunction
+
+    function [31:0] reverse_bytes(input [31:0] data);
+        integer k;
+        begin
+            for (k = 0; k < 4; k = k + 1) begin
+                reverse_bytes[k*8+:8] = data[8*(3-k)+:8];
+            end
+        end
+    endfunction
+
+    reg busy;
+    reg [5:0] round;
+    reg [31:0] work [0:15];
+    reg [31:0] AA, BB, CC, DD;
+    reg [31:0] A, B, C, D;  // Result of the last block
+
+    assign idle = !busy && !valid;
+    assign digest = {reverse_bytes(A), reverse_bytes(B), reverse_bytes(C), reverse_bytes(D)};
+
+    // Current round
+    wire [31:0] F = (round < 16) ? ((BB & CC) | (~BB & DD)) :
+                    (round < 32) ? ((BB & DD) | (CC & ~DD)) :
+                    (round < 48) ? (BB ^ CC ^ DD) :
+                                   (CC ^ (BB | ~DD));
+    wire [31:0] sum = F + AA + md5_k(round) + work[md5_g(round)];
+    wire [4:0] shift = md5_s(round);
+    wire [31:0] rotated = (sum << shift) | (sum >> (6'd32 - shift));
+
+    integer i;
+    always @(posedge clk) begin
+        if (reset) begin
+            busy <= 0;
+            valid <= 0;
+            round <= 0;
+        end else if (busy) begin
+            AA <= DD;
+            DD <= CC;
+            CC <= BB;
+            BB <= BB + rotated;
+            round <= round + 1;
+
+            if (round == 63) begin
+                A <= 32'h67452301 + DD;
+                B <= 32'hefcdab89 + BB + rotated;
+                C <= 32'h98badcfe + BB;
+                D <= 32'h10325476 + CC;
+                busy <= 0;
+                valid <= 1;
+            end
+        end else if (valid) begin
+            if (ack) valid <= 0;
+        end else if (start) begin
+            // Split the block into 32-bit words and reverse the byte order
+            for (i = 0; i < 16; i = i + 1) begin
+                work[i] <= reverse_bytes(block[32*i +: 32]);
+            end
+            AA <= 32'h67452301;
+            BB <= 32'hefcdab89;
+            CC <= 32'h98badcfe;
+            DD <= 32'h10325476;
+            round <= 0;
+            busy <= 1;
+        end
+    end
+endmodule
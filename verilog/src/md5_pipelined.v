@@ -0,0 +1,136 @@
+`timescale 1ns / 1ps
+
+// Fully pipelined MD5 block core: all 64 rounds are unrolled into their own pipeline stage, so a new
+// 512-bit block can enter on every clock. Each block carries the chaining value of its stream and a tag,
+// and leaves 65 clocks later with the updated chaining value and the same tag.
+module md5_pipelined #(
+        parameter TAG_WIDTH = 8
+    ) (
+        input wire clk,
+        input wire reset,
+        input wire in_valid,                // A block is presented this cycle
+        input wire [0:511] block,           // Padded 512-bit block, first message byte in block[0:7]
+        input wire [127:0] state_in,        // Chaining value {A, B, C, D} of the stream (IV for a first block)
+        input wire [TAG_WIDTH-1:0] in_tag,  // Identifies the stream the block belongs to
+        output wire out_valid,
+        output wire [127:0] state_out,      // Updated chaining value {A, B, C, D}
+        output wire [127:0] digest,         // state_out in digest byte order, as the md5 core reports it
+        output wire [TAG_WIDTH-1:0] out_tag
+    );
+
+    // The constants for each round
+    function [31:0] md5_k(input integer i);
+        case (i)
+            0:  md5_k = 32'hd76aa478;   1:  md5_k = 32'he8c7b756;   2:  md5_k = 32'h242070db;   3:  md5_k = 32'hc1bdceee;
+            4:  md5_k = 32'hf57c0faf;   5:  md5_k = 32'h4787c62a;   6:  md5_k = 32'ha8304613;   7:  md5_k = 32'hfd469501;
+            8:  md5_k = 32'h698098d8;   9:  md5_k = 32'h8b44f7af;   10: md5_k = 32'hffff5bb1;   11: md5_k = 32'h895cd7be;
+            12: md5_k = 32'h6b901122;   13: md5_k = 32'hfd987193;   14: md5_k = 32'ha679438e;   15: md5_k = 32'h49b40821;
+            16: md5_k = 32'hf61e2562;   17: md5_k = 32'hc040b340;   18: md5_k = 32'h265e5a51;   19: md5_k = 32'he9b6c7aa;
+            20: md5_k = 32'hd62f105d;   21: md5_k = 32'h02441453;   22: md5_k = 32'hd8a1e681;   23: md5_k = 32'he7d3fbc8;
+            24: md5_k = 32'h21e1cde6;   25: md5_k = 32'hc33707d6;   26: md5_k = 32'hf4d50d87;   27: md5_k = 32'h455a14ed;
+            28: md5_k = 32'ha9e3e905;   29: md5_k = 32'hfcefa3f8;   30: md5_k = 32'h676f02d9;   31: md5_k = 32'h8d2a4c8a;
+            32: md5_k = 32'hfffa3942;   33: md5_k = 32'h8771f681;   34: md5_k = 32'h6d9d6122;   35: md5_k = 32'hfde5380c;
+            36: md5_k = 32'ha4beea44;   37: md5_k = 32'h4bdecfa9;   38: md5_k = 32'hf6bb4b60;   39: md5_k = 32'hbebfbc70;
+            40: md5_k = 32'h289b7ec6;   41: md5_k = 32'heaa127fa;   42: md5_k = 32'hd4ef3085;   43: md5_k = 32'h04881d05;
+            44: md5_k = 32'hd9d4d039;   45: md5_k = 32'he6db99e5;   46: md5_k = 32'h1fa27cf8;   47: md5_k = 32'hc4ac5665;
+            48: md5_k = 32'hf4292244;   49: md5_k = 32'h432aff97;   50: md5_k = 32'hab9423a7;   51: md5_k = 32'hfc93a039;
+            52: md5_k = 32'h655b59c3;   53: md5_k = 32'h8f0ccc92;   54: md5_k = 32'hffeff47d;   55: md5_k = 32'h85845dd1;
+            56: md5_k = 32'h6fa87e4f;   57: md5_k = 32'hfe2ce6e0;   58: md5_k = 32'ha3014314;   59: md5_k = 32'h4e0811a1;
+            60: md5_k = 32'hf7537e82;   61: md5_k = 32'hbd3af235;   62: md5_k = 32'h2ad7d2bb;   default: md5_k = 32'heb86d391;
+        endcase
+    endfunction
+
+    // The rotation amounts for each round
+    function integer md5_s(input integer i);
+        case (i / 16)
+            0: md5_s = (i % 4 == 0) ? 7 : (i % 4 == 1) ? 12 : (i % 4 == 2) ? 17 : 22;
+            1: md5_s = (i % 4 == 0) ? 5 : (i % 4 == 1) ? 9 : (i % 4 == 2) ? 14 : 20;
+            2: md5_s = (i % 4 == 0) ? 4 : (i % 4 == 1) ? 11 : (i % 4 == 2) ? 16 : 23;
+            default: md5_s = (i % 4 == 0) ? 6 : (i % 4 == 1) ? 10 : (i % 4 == 2) ? 15 : 21;
+        endcase
+    endfunction
+
+    // The message word used by each round
+    function integer md5_g(input integer i);
+        case (i / 16)
+            0: md5_g = i;
+            1: md5_g = (5*i + 1) % 16;
+            2: md5_g = (3*i + 5) % 16;
+            default: md5_g = (7*i) % 16;
+        endcase
+    endfunction
+
+    function [31:0] reverse_bytes(input [31:0] data);
+        integer k;
+        begin
+            for (k = 0; k < 4; k = k + 1) begin
+                reverse_bytes[k*8+:8] = data[8*(3-k)+:8];
+            end
+        end
+    endfunction
+
+    // Stage 0 registers the input block; stage s (1..64) holds the result of round s-1.
+    // Every stage carries the block's message words, its original chaining value, its tag and a valid bit.
+    genvar s, j;
+    generate
+        for (s = 0; s <= 64; s = s + 1) begin : stage
+            reg [31:0] a, b, c, d;
+            reg [127:0] iv;
+            reg [511:0] m;  // Message word j (little-endian) in m[32*j +: 32]
+            reg [TAG_WIDTH-1:0] tag;
+            reg valid;
+
+            if (s == 0) begin : load
+                wire [511:0] words;
+                for (j = 0; j < 16; j = j + 1) begin : split
+                    assign words[32*j +: 32] = reverse_bytes(block[32*j +: 32]);
+                end
+
+                always @(posedge clk) begin
+                    {a, b, c, d} <= state_in;
+                    iv <= state_in;
+                    m <= words;
+                    tag <= in_tag;
+                    valid <= reset ? 1'b0 : in_valid;
+                end
+            end else begin : round
+                localparam integer R = s - 1;
+                localparam [31:0] K = md5_k(R);
+                localparam integer S = md5_s(R);
+                localparam integer G = md5_g(R);
+
+                wire [31:0] pb = stage[s-1].b;
+                wire [31:0] pc = stage[s-1].c;
+                wire [31:0] pd = stage[s-1].d;
+                wire [31:0] F = (R < 16) ? ((pb & pc) | (~pb & pd)) :
+                                (R < 32) ? ((pb & pd) | (pc & ~pd)) :
+                                (R < 48) ? (pb ^ pc ^ pd) :
+                                           (pc ^ (pb | ~pd));
+                wire [31:0] sum = F + stage[s-1].a + K + stage[s-1].m[32*G +: 32];
+                wire [31:0] rotated = (sum << S) | (sum >> (32 - S));
+
+                always @(posedge clk) begin
+                    a <= pd;
+                    b <= pb + rotated;
+                    c <= pb;
+                    d <= pc;
+                    iv <= stage[s-1].iv;
+                    m <= stage[s-1].m;
+                    tag <= stage[s-1].tag;
+                    valid <= reset ? 1'b0 : stage[s-1].valid;
+                end
+            end
+        end
+    endgenerate
+
+    // Add the block's result to the chaining value it started from
+    wire [31:0] A = stage[64].iv[127:96] + stage[64].a;
+    wire [31:0] B = stage[64].iv[95:64] + stage[64].b;
+    wire [31:0] C = stage[64].iv[63:32] + stage[64].c;
+    wire [31:0] D = stage[64].iv[31:0] + stage[64].d;
+
+    assign out_valid = stage[64].valid;
+    assign out_tag = stage[64].tag;
+    assign state_out = {A, B, C, D};
+    assign digest = {reverse_bytes(A), reverse_bytes(B), reverse_bytes(C), reverse_bytes(D)};
+endmodule
@@ -0,0 +1,122 @@
+`timescale 1ns / 1ps
+
+module tb_md5_pipelined;
+    // Number of test vectors in VECTOR_FILE, written by `md5_cpp --vectors` from the C++ calculate()
+    parameter NUM_VECTORS = 1024;
+    parameter VECTOR_FILE = "md5_vectors.hex";
+
+    // Inputs
+    reg clk;
+    reg reset;
+    reg in_valid;
+    reg [0:511] block;
+    reg [127:0] state_in;
+    reg [15:0] in_tag;
+
+    // Outputs
+    wire out_valid;
+    wire [127:0] state_out;
+    wire [127:0] digest;
+    wire [15:0] out_tag;
+
+    // Each vector is a padded single-block message followed by its expected digest
+    reg [639:0] vectors [0:NUM_VECTORS-1];
+
+    integer issued;
+    integer received;
+    integer errors;
+    integer cycle;
+    integer first_in_cycle;
+    integer first_out_cycle;
+    integer last_out_cycle;
+
+    // Instantiate the Unit Under Test (UUT)
+    md5_pipelined #(.TAG_WIDTH(16)) uut (
+        .clk(clk),
+        .reset(reset),
+        .in_valid(in_valid),
+        .block(block),
+        .state_in(state_in),
+        .in_tag(in_tag),
+        .out_valid(out_valid),
+        .state_out(state_out),
+        .digest(digest),
+        .out_tag(out_tag)
+    );
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #0.185 clk = !clk;  // Clock with a period of 370ps (2.7 GHz like iMac CPU)
+    end
+
+    // Count cycles and check every digest that leaves the pipeline against the vector its tag names
+    always @(posedge clk) begin
+        cycle <= cycle + 1;
+        if (out_valid) begin
+            if (received == 0) first_out_cycle = cycle;
+            last_out_cycle = cycle;
+            received = received + 1;
+
+            if (digest !== vectors[out_tag][127:0]) begin
+                errors = errors + 1;
+                $display("Vector %0d: digest %h, expected %h", out_tag, digest, vectors[out_tag][127:0]);
+            end
+        end
+    end
+
+    // Test vectors and checker
+    initial begin
+        $readmemh(VECTOR_FILE, vectors);
+
+        // Initialize Inputs
+        reset = 1;
+        in_valid = 0;
+        block = 0;
+        state_in = 0;
+        in_tag = 0;
+        cycle = 0;
+        issued = 0;
+        received = 0;
+        errors = 0;
+
+        // Wait for global reset to finish
+        @(posedge clk);
+        @(posedge clk);
+        #0.1;
+        reset = 0;
+
+        // Issue one independent block every cycle
+        while (issued < NUM_VECTORS) begin
+            in_valid = 1;
+            block = vectors[issued][639:128];
+            state_in = {32'h67452301, 32'hefcdab89, 32'h98badcfe, 32'h10325476};
+            in_tag = issued;
+            if (issued == 0) first_in_cycle = cycle;
+            @(posedge clk);
+            #0.1;
+            issued = issued + 1;
+        end
+        in_valid = 0;
+
+        // Drain the pipeline
+        wait (received == NUM_VECTORS);
+        @(posedge clk);
+
+        $display("Blocks: %0d, latency: %0d cycles", NUM_VECTORS, first_out_cycle - first_in_cycle);
+        $display("Sustained throughput: %0d blocks in %0d cycles (%f blocks/cycle)",
+                 NUM_VECTORS, last_out_cycle - first_out_cycle + 1,
+                 NUM_VECTORS * 1.0 / (last_out_cycle - first_out_cycle + 1));
+
+        if (errors == 0) begin
+            $display("Test Passed. All %0d digests match the C++ implementation.", NUM_VECTORS);
+        end else begin
+            $display("Test Failed. %0d of %0d digests do not match.", errors, NUM_VECTORS);
+        end
+
+        // End simulation
+        #0.37;
+        $finish;
+    end
+
+endmodule
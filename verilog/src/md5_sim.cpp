@@ -0,0 +1,147 @@
+// Verilator harness for md5.v: hashes random messages on the verilated core, checks every digest
+// against the C++ implementation and reports the cycle counts of the core.
+//
+// Usage: md5_sim [messages] [seed] [clock MHz]
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include "Vmd5.h"
+#include "verilated.h"
+#include "md5.h"
+
+// md5.v takes at most 440 message bits in its single block
+static const int maxMessageBytes = 55;
+static const int timeoutCycles = 1000;
+
+static uint64_t cycles = 0;
+
+static void tick(Vmd5& top) {
+    top.clk = 0;
+    top.eval();
+    top.clk = 1;
+    top.eval();
+    cycles++;
+}
+
+// The message port is declared [0:511] and the core takes the message right-aligned in it, so the
+// last message byte sits in the least significant bits of the verilated value.
+static void setMessage(Vmd5& top, const std::string& message) {
+    for (int w = 0; w < 16; w++) top.message[w] = 0;
+
+    size_t length = message.size();
+    for (size_t k = 0; k < length; k++) {
+        uint8_t byte = message[length - 1 - k];
+        top.message[k / 4] |= (uint32_t)byte << (8 * (k % 4));
+    }
+    top.message_len = 8 * (uint64_t)length;
+}
+
+// digest[127:120] is the first byte of the digest
+static std::array<uint8_t, 16> getDigest(const Vmd5& top) {
+    std::array<uint8_t, 16> digest;
+    for (int j = 0; j < 16; j++) {
+        digest[j] = (uint8_t)(top.digest[3 - j / 4] >> (24 - 8 * (j % 4)));
+    }
+    return digest;
+}
+
+static void printHex(const std::array<uint8_t, 16>& bytes) {
+    for (uint8_t byte : bytes) {
+        std::cout << std::hex << std::setw(2) << std::setfill('0') << (int)byte;
+    }
+    std::cout << std::dec;
+}
+
+int main(int argc, char** argv) {
+    uint64_t messages = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    uint64_t seed = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1;
+    double clockMHz = (argc > 3) ? std::atof(argv[3]) : 100.0;
+
+    VerilatedContext context;
+    Vmd5 top{&context};
+    std::mt19937_64 rng(seed);
+
+    uint64_t mismatches = 0;
+    uint64_t timeouts = 0;
+    uint64_t messageBytes = 0;
+    uint64_t busyCycles = 0;  // From the start pulse to ready
+    uint64_t minLatency = UINT64_MAX;
+    uint64_t maxLatency = 0;
+
+    auto wallStart = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t n = 0; n < messages; n++) {
+        std::string message(rng() % (maxMessageBytes + 1), '\0');
+        for (char& c : message) c = (char)rng();
+        messageBytes += message.size();
+
+        // The core keeps its chaining values and ready flag until reset, so every message starts with one
+        top.reset = 1;
+        top.start = 0;
+        tick(top);
+        top.reset = 0;
+
+        setMessage(top, message);
+        top.start = 1;
+        tick(top);
+        top.start = 0;
+
+        uint64_t latency = 1;
+        while (!top.ready && latency < timeoutCycles) {
+            tick(top);
+            latency++;
+        }
+
+        if (!top.ready) {
+            timeouts++;
+            continue;
+        }
+
+        busyCycles += latency;
+        minLatency = std::min(minLatency, latency);
+        maxLatency = std::max(maxLatency, latency);
+
+        std::array<uint8_t, 16> expected = calculate(message);
+        std::array<uint8_t, 16> digest = getDigest(top);
+        if (digest != expected) {
+            if (mismatches < 10) {
+                std::cout << "Message " << n << " (" << message.size() << " bytes): digest ";
+                printHex(digest);
+                std::cout << ", expected ";
+                printHex(expected);
+                std::cout << "\n";
+            }
+            mismatches++;
+        }
+    }
+
+    top.final();
+
+    auto wallEnd = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> wall = wallEnd - wallStart;
+
+    uint64_t checked = messages - timeouts;
+    double cyclesPerBlock = checked ? (double)busyCycles / checked : 0;  // Every message is a single block
+    double totalPerBlock = messages ? (double)cycles / messages : 0;     // Including the reset and start cycles
+
+    std::cout << "Messages: " << messages << " (" << messageBytes << " bytes), seed " << seed << "\n";
+    std::cout << "Latency: " << minLatency << " - " << maxLatency << " cycles from start to ready\n";
+    std::cout << "Cycles per block: " << cyclesPerBlock << " (" << totalPerBlock << " with reset and start)\n";
+    std::cout << "Throughput at " << clockMHz << " MHz: " << clockMHz * 1e6 / totalPerBlock << " blocks/s, "
+              << clockMHz * messageBytes / cycles << " MB/s of message data\n";
+    std::cout << "Simulation: " << cycles << " cycles in " << wall.count() << " s ("
+              << cycles / wall.count() << " cycles/s)\n";
+
+    if (mismatches == 0 && timeouts == 0) {
+        std::cout << "Test Passed. All " << messages << " digests match the C++ implementation.\n";
+        return 0;
+    }
+
+    std::cout << "Test Failed. " << mismatches << " mismatches, " << timeouts << " timeouts.\n";
+    return 1;
+}
@@ -0,0 +1,222 @@
+`timescale 1ns / 1ps
+
+// MD5 core with an AXI-Stream style input: messages of any length arrive one 32-bit word per transfer
+// (byte 0 of the word in s_tdata[7:0], which is already MD5's little-endian word order), with s_tlast
+// and s_tkeep marking the final, possibly partial word. The chaining value is carried between blocks
+// and the final padding is applied by the core. A block is filled while the previous one is being
+// compressed; s_tready drops (backpressure) when both are taken.
+module md5_stream (
+        input wire clk,
+        input wire reset,
+
+        // Message input
+        input wire [31:0] s_tdata,
+        input wire [3:0] s_tkeep,     // Valid bytes of the last word, contiguous from byte 0 (4'b0000 for none)
+        input wire s_tlast,
+        input wire s_tvalid,
+        output wire s_tready,
+
+        // Digest output
+        output wire [127:0] m_tdata,  // Digest in the same byte order as the md5 core
+        output reg m_tvalid,
+        input wire m_tready
+    );
+
+    // The constants for each round
+    function [31:0] md5_k(input [5:0] i);
+        case (i)
+            0:  md5_k = 32'hd76aa478;   1:  md5_k = 32'he8c7b756;   2:  md5_k = 32'h242070db;   3:  md5_k = 32'hc1bdceee;
+            4:  md5_k = 32'hf57c0faf;   5:  md5_k = 32'h4787c62a;   6:  md5_k = 32'ha8304613;   7:  md5_k = 32'hfd469501;
+            8:  md5_k = 32'h698098d8;   9:  md5_k = 32'h8b44f7af;   10: md5_k = 32'hffff5bb1;   11: md5_k = 32'h895cd7be;
+            12: md5_k = 32'h6b901122;   13: md5_k = 32'hfd987193;   14: md5_k = 32'ha679438e;   15: md5_k = 32'h49b40821;
+            16: md5_k = 32'hf61e2562;   17: md5_k = 32'hc040b340;   18: md5_k = 32'h265e5a51;   19: md5_k = 32'he9b6c7aa;
+            20: md5_k = 32'hd62f105d;   21: md5_k = 32'h02441453;   22: md5_k = 32'hd8a1e681;   23: md5_k = 32'he7d3fbc8;
+            24: md5_k = 32'h21e1cde6;   25: md5_k = 32'hc33707d6;   26: md5_k = 32'hf4d50d87;   27: md5_k = 32'h455a14ed;
+            28: md5_k = 32'ha9e3e905;   29: md5_k = 32'hfcefa3f8;   30: md5_k = 32'h676f02d9;   31: md5_k = 32'h8d2a4c8a;
+            32: md5_k = 32'hfffa3942;   33: md5_k = 32'h8771f681;   34: md5_k = 32'h6d9d6122;   35: md5_k = 32'hfde5380c;
+            36: md5_k = 32'ha4beea44;   37: md5_k = 32'h4bdecfa9;   38: md5_k = 32'hf6bb4b60;   39: md5_k = 32'hbebfbc70;
+            40: md5_k = 32'h289b7ec6;   41: md5_k = 32'heaa127fa;   42: md5_k = 32'hd4ef3085;   43: md5_k = 32'h04881d05;
+            44: md5_k = 32'hd9d4d039;   45: md5_k = 32'he6db99e5;   46: md5_k = 32'h1fa27cf8;   47: md5_k = 32'hc4ac5665;
+            48: md5_k = 32'hf4292244;   49: md5_k = 32'h432aff97;   50: md5_k = 32'hab9423a7;   51: md5_k = 32'hfc93a039;
+            52: md5_k = 32'h655b59c3;   53: md5_k = 32'h8f0ccc92;   54: md5_k = 32'hffeff47d;   55: md5_k = 32'h85845dd1;
+            56: md5_k = 32'h6fa87e4f;   57: md5_k = 32'hfe2ce6e0;   58: md5_k = 32'ha3014314;   59: md5_k = 32'h4e0811a1;
+            60: md5_k = 32'hf7537e82;   61: md5_k = 32'hbd3af235;   62: md5_k = 32'h2ad7d2bb;   default: md5_k = 32'heb86d391;
+        endcase
+    endfunction
+
+    // The rotation amounts for each round
+    function [4:0] md5_s(input [5:0] i);
+        case ({i[5:4], i[1:0]})
+            4'b0000: md5_s = 7;   4'b0001: md5_s = 12;  4'b0010: md5_s = 17;  4'b0011: md5_s = 22;
+            4'b0100: md5_s = 5;   4'b0101: md5_s = 9;   4'b0110: md5_s = 14;  4'b0111: md5_s = 20;
+            4'b1000: md5_s = 4;   4'b1001: md5_s = 11;  4'b1010: md5_s = 16;  4'b1011: md5_s = 23;
+            4'b1100: md5_s = 6;   4'b1101: md5_s = 10;  4'b1110: md5_s = 15;  default: md5_s = 21;
+        endcase
+    endfunction
+
+    // The message word used by each round (all arithmetic is modulo 16)
+    function [3:0] md5_g(input [5:0] i);
+        case (i[5:4])
+            2'd0: md5_g = i[3:0];
+            2'd1: md5_g = 5*i[3:0] + 1;
+            2'd2: md5_g = 3*i[3:0] + 5;
+            default: md5_g = 7*i[3:0];
+        endcase
+    endfunction
+
+    function [31:0] reverse_bytes(input [31:0] data);
+        integer k;
+        begin
+            for (k = 0; k < 4; k = k + 1) begin
+                reverse_bytes[k*8+:8] = data[8*(3-k)+:8];
+            end
+        end
+    endfunction
+
+    localparam FILL = 2'd0;  // Accepting message words
+    localparam PAD  = 2'd1;  // Writing the 0x80 byte, zeros and the bit length after the last word
+    localparam DONE = 2'd2;  // Last block handed to the compressor, waiting for the digest to be taken
+
+    // Fill side: the block being assembled
+    reg [1:0] fstate;
+    reg [31:0] fill [0:15];
+    reg [3:0] wptr;           // Next word of the fill block
+    reg full;                 // The fill block is complete and waits for the compressor
+    reg full_last;            // ... and it is the final block of the message
+    reg pad_pending;          // The 0x80 byte still has to start the next word
+    reg [63:0] len;           // Message length in bytes
+
+    // Compressor side: one round per clock
+    reg busy;
+    reg last;
+    reg [5:0] round;
+    reg [31:0] work [0:15];
+    reg [31:0] H0, H1, H2, H3;  // Chaining value
+    reg [31:0] AA, BB, CC, DD;
+
+    assign s_tready = (fstate == FILL) && !full && !reset;
+    assign m_tdata = {reverse_bytes(H0), reverse_bytes(H1), reverse_bytes(H2), reverse_bytes(H3)};
+
+    // Last word: keep the valid bytes and append the 0x80 byte straight after them
+    wire [2:0] nbytes = s_tkeep[3] ? 3'd4 : s_tkeep[2] ? 3'd3 : s_tkeep[1] ? 3'd2 : s_tkeep[0] ? 3'd1 : 3'd0;
+    wire [31:0] keep_mask = {{8{s_tkeep[3]}}, {8{s_tkeep[2]}}, {8{s_tkeep[1]}}, {8{s_tkeep[0]}}};
+    wire [31:0] last_word = (nbytes == 3'd4) ? s_tdata : ((s_tdata & keep_mask) | (32'h80 << (8 * nbytes)));
+
+    // Current round
+    wire [31:0] F = (round < 16) ? ((BB & CC) | (~BB & DD)) :
+                    (round < 32) ? ((BB & DD) | (CC & ~DD)) :
+                    (round < 48) ? (BB ^ CC ^ DD) :
+                                   (CC ^ (BB | ~DD));
+    wire [31:0] sum = F + AA + md5_k(round) + work[md5_g(round)];
+    wire [4:0] shift = md5_s(round);
+    wire [31:0] rotated = (sum << shift) | (sum >> (6'd32 - shift));
+
+    integer i;
+    always @(posedge clk) begin
+        if (reset) begin
+            fstate <= FILL;
+            wptr <= 0;
+            full <= 0;
+            full_last <= 0;
+            pad_pending <= 0;
+            len <= 0;
+            busy <= 0;
+            last <= 0;
+            round <= 0;
+            m_tvalid <= 0;
+            H0 <= 32'h67452301;  // Resetting MD buffers to initial values
+            H1 <= 32'hefcdab89;
+            H2 <= 32'h98badcfe;
+            H3 <= 32'h10325476;
+        end else begin
+            // Fill side
+            case (fstate)
+                FILL: begin
+                    if (s_tvalid && s_tready) begin
+                        if (!s_tlast) begin
+                            fill[wptr] <= s_tdata;
+                            len <= len + 4;
+                        end else begin
+                            fill[wptr] <= last_word;
+                            pad_pending <= (nbytes == 3'd4);
+                            len <= len + nbytes;
+                            fstate <= PAD;
+                        end
+
+                        if (wptr == 15) begin
+                            full <= 1;
+                            full_last <= 0;
+                        end
+                        wptr <= wptr + 1;
+                    end
+                end
+                PAD: begin
+                    // The block must have been handed over before its words are reused
+                    if (!full) begin
+                        if (wptr == 14 && !pad_pending) begin
+                            fill[14] <= {len[28:0], 3'b000};  // Bit length, low word first
+                            fill[15] <= len[60:29];
+                            full <= 1;
+                            full_last <= 1;
+                            wptr <= 0;
+                            fstate <= DONE;
+                        end else begin
+                            fill[wptr] <= pad_pending ? 32'h00000080 : 32'h00000000;
+                            pad_pending <= 0;
+                            if (wptr == 15) begin
+                                full <= 1;
+                                full_last <= 0;
+                            end
+                            wptr <= wptr + 1;
+                        end
+                    end
+                end
+                default: begin
+                    // DONE: start over once the digest has been taken
+                    if (m_tvalid && m_tready) begin
+                        m_tvalid <= 0;
+                        len <= 0;
+                        H0 <= 32'h67452301;
+                        H1 <= 32'hefcdab89;
+                        H2 <= 32'h98badcfe;
+                        H3 <= 32'h10325476;
+                        fstate <= FILL;
+                    end
+                end
+            endcase
+
+            // Compressor side
+            if (!busy) begin
+                if (full) begin
+                    for (i = 0; i < 16; i = i + 1) begin
+                        work[i] <= fill[i];
+                    end
+                    AA <= H0;
+                    BB <= H1;
+                    CC <= H2;
+                    DD <= H3;
+                    last <= full_last;
+                    round <= 0;
+                    busy <= 1;
+                    full <= 0;
+                end
+            end else begin
+                AA <= DD;
+                DD <= CC;
+                CC <= BB;
+                BB <= BB + rotated;
+                round <= round + 1;
+
+                if (round == 63) begin
+                    // Add this block's hash to the result so far
+                    H0 <= H0 + DD;
+                    H1 <= H1 + BB + rotated;
+                    H2 <= H2 + BB;
+                    H3 <= H3 + CC;
+                    busy <= 0;
+                    if (last) m_tvalid <= 1;
+                end
+            end
+        end
+    end
+endmodule
@@ -0,0 +1,83 @@
+`timescale 1ns / 1ps
+
+// MD6 compression function: one round (16 steps) per clock. No step of a round reads a word written in
+// the same round (the smallest tap is 17), so the 16 steps are computed side by side from an 89-word
+// shift register that advances by 16 words per clock. The round constant S is updated alongside.
+module md6_compress (
+        input wire clk,
+        input wire reset,
+        input wire start,                // Load N and begin; ignored while busy
+        input wire [64*89-1:0] N,        // Q, K, U, V and B; word k in N[64*k +: 64]
+        input wire [7:0] r,              // Number of rounds
+        output reg busy,
+        output reg valid,                // C holds the result of the last compression
+        output wire [64*16-1:0] C        // The last 16 words computed; word j in C[64*j +: 64]
+    );
+
+    // Right/left shift amounts for each of the 16 steps of a round
+    function integer md6_r_shift(input integer step);
+        case (step)
+            0: md6_r_shift = 10;   1: md6_r_shift = 5;    2: md6_r_shift = 13;   3: md6_r_shift = 10;
+            4: md6_r_shift = 11;   5: md6_r_shift = 12;   6: md6_r_shift = 2;    7: md6_r_shift = 7;
+            8: md6_r_shift = 14;   9: md6_r_shift = 15;   10: md6_r_shift = 7;   11: md6_r_shift = 13;
+            12: md6_r_shift = 11;  13: md6_r_shift = 7;   14: md6_r_shift = 6;   default: md6_r_shift = 12;
+        endcase
+    endfunction
+
+    function integer md6_l_shift(input integer step);
+        case (step)
+            0: md6_l_shift = 11;   1: md6_l_shift = 24;   2: md6_l_shift = 9;    3: md6_l_shift = 16;
+            4: md6_l_shift = 15;   5: md6_l_shift = 9;    6: md6_l_shift = 27;   7: md6_l_shift = 15;
+            8: md6_l_shift = 6;    9: md6_l_shift = 2;    10: md6_l_shift = 29;  11: md6_l_shift = 8;
+            12: md6_l_shift = 15;  13: md6_l_shift = 5;   14: md6_l_shift = 31;  default: md6_l_shift = 9;
+        endcase
+    endfunction
+
+    // Word k of A is the word 89 - k positions before the next one to be computed, so the taps
+    // t0 = 17, 18, 21, 31, 67 and 89 of step j are words 89 - t0 + j
+    reg [64*89-1:0] A;
+    reg [63:0] S;
+    reg [7:0] remaining;
+
+    wire [64*16-1:0] round_out;
+
+    genvar j;
+    generate
+        for (j = 0; j < 16; j = j + 1) begin : step
+            localparam integer RS = md6_r_shift(j);
+            localparam integer LS = md6_l_shift(j);
+
+            wire [63:0] x = S ^ A[64*j +: 64] ^ A[64*(72+j) +: 64]
+                            ^ (A[64*(71+j) +: 64] & A[64*(68+j) +: 64])
+                            ^ (A[64*(58+j) +: 64] & A[64*(22+j) +: 64]);
+            wire [63:0] y = x ^ (x >> RS);
+            assign round_out[64*j +: 64] = y ^ (y << LS);
+        end
+    endgenerate
+
+    assign C = A[64*73 +: 64*16];
+
+    always @(posedge clk) begin
+        if (reset) begin
+            busy <= 0;
+            valid <= 0;
+            remaining <= 0;
+        end else if (busy) begin
+            // Drop the 16 oldest words and append the new round
+            A <= {round_out, A[64*89-1:64*16]};
+            S <= {S[62:0], S[63]} ^ (S & 64'h7311c2812425cfa0);
+            remaining <= remaining - 1;
+
+            if (remaining == 1) begin
+                busy <= 0;
+                valid <= 1;
+            end
+        end else if (start) begin
+            A <= N;
+            S <= 64'h0123456789abcdef;
+            remaining <= r;
+            busy <= (r != 0);
+            valid <= (r == 0);
+        end
+    end
+endmodule
@@ -0,0 +1,120 @@
+`timescale 1ns / 1ps
+
+module tb_md6_compress;
+    // Number of test vectors in VECTOR_FILE, written by `md6_cpp --vectors` from md6_standard_compress()
+    parameter NUM_VECTORS = 256;
+    parameter VECTOR_FILE = "md6_vectors.hex";
+
+    // Inputs
+    reg clk;
+    reg reset;
+    reg start;
+    reg [64*89-1:0] N;
+    reg [7:0] r;
+
+    // Outputs
+    wire busy;
+    wire valid;
+    wire [64*16-1:0] C;
+
+    // Each vector is r, the 89 words of N and the 16 words of C, first word in the most significant bits
+    reg [64*106-1:0] vectors [0:NUM_VECTORS-1];
+    reg [64*16-1:0] expected;
+
+    integer t;
+    integer k;
+    integer errors;
+    integer cycle;
+    integer start_cycle;
+    integer total_cycles;
+    integer total_rounds;
+
+    // Instantiate the Unit Under Test (UUT)
+    md6_compress uut (
+        .clk(clk),
+        .reset(reset),
+        .start(start),
+        .N(N),
+        .r(r),
+        .busy(busy),
+        .valid(valid),
+        .C(C)
+    );
+
+    // Clock generation
+    initial begin
+        clk = 0;
+        forever #0.185 clk = !clk;  // Clock with a period of 370ps (2.7 GHz like iMac CPU)
+    end
+
+    always @(posedge clk) begin
+        cycle <= cycle + 1;
+    end
+
+    // Test vectors and checker
+    initial begin
+        $readmemh(VECTOR_FILE, vectors);
+
+        // Initialize Inputs
+        reset = 1;
+        start = 0;
+        N = 0;
+        r = 0;
+        cycle = 0;
+        errors = 0;
+        total_cycles = 0;
+        total_rounds = 0;
+
+        // Wait for global reset to finish
+        @(posedge clk);
+        @(posedge clk);
+        #0.1;
+        reset = 0;
+
+        for (t = 0; t < NUM_VECTORS; t = t + 1) begin
+            r = vectors[t][64*105 +: 8];
+            for (k = 0; k < 89; k = k + 1) begin
+                N[64*k +: 64] = vectors[t][64*(104-k) +: 64];
+            end
+            for (k = 0; k < 16; k = k + 1) begin
+                expected[64*k +: 64] = vectors[t][64*(15-k) +: 64];
+            end
+
+            // Start the compression and wait for its result
+            start = 1;
+            start_cycle = cycle;
+            @(posedge clk);
+            #0.1;
+            start = 0;
+
+            while (!valid) begin
+                @(posedge clk);
+                #0.1;
+            end
+
+            total_cycles = total_cycles + (cycle - start_cycle);
+            total_rounds = total_rounds + r;
+
+            if (C !== expected) begin
+                errors = errors + 1;
+                $display("Vector %0d (r = %0d): C %h, expected %h", t, r, C, expected);
+            end
+        end
+
+        $display("Compressions: %0d, %0d rounds in %0d cycles (%f cycles per round)",
+                 NUM_VECTORS, total_rounds, total_cycles, total_cycles * 1.0 / total_rounds);
+        $display("Cycles per compression: %f on average (%f bytes of B per cycle)",
+                 total_cycles * 1.0 / NUM_VECTORS, 512.0 * NUM_VECTORS / total_cycles);
+
+        if (errors == 0) begin
+            $display("Test Passed. All %0d compressions match md6_standard_compress.", NUM_VECTORS);
+        end else begin
+            $display("Test Failed. %0d of %0d compressions do not match.", errors, NUM_VECTORS);
+        end
+
+        // End simulation
+        #0.37;
+        $finish;
+    end
+
+endmodule